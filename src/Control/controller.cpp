@@ -0,0 +1,378 @@
+#include <Control/controller.h>
+#include "Control/firingPolicies.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const uint32_t Controller::maxThrottle;
+
+Controller::Controller() : tickFunction(tickFunctionFor(NO_PUSHER, false)) {}
+
+void Controller::configure(const controlParams_t &newParams)
+{
+  params = newParams;
+  tickFunction = tickFunctionFor(params.pusherType, params.closedLoopFlywheels);
+  scaledMotorKv = params.motorKv * 11;
+  scheduler.configure(params.fire);
+  const idleBounds_t bounds = {
+      params.idleRPM,
+      params.idleRPMMax,
+      params.idleTimeMin_ms,
+      params.idleTime_ms,
+      params.idleActiveGap_ms,
+      params.idleLowBattery_mv,
+  };
+  // changing anything else keeps what the governor learned about the player, and the current lull
+  if (!governor.hasBounds(bounds))
+  {
+    governor.configure(bounds);
+    releaseTime_ms = 0;
+  }
+}
+
+void Controller::reset()
+{
+  scheduler.cancel();
+  pusher.firing = false;
+  pusher.on = false;
+  pusher.brake = false;
+  pusher.throttle = 0;
+  state = STATE_IDLE;
+  lastRevTime_ms = 0; // no idling afterwards either
+  releaseTime_ms = 0;
+  targetRPM = 0;
+  throttle = 0;
+}
+
+controlState_t Controller::saveState() const
+{
+  return {
+      scheduler.saveState(), governor.saveState(), pusher, state, lastTrigger, lastCycle,
+      lastRevTime_ms, releaseTime_ms, accelerationTime_ms, targetRPM, throttle,
+  };
+}
+
+void Controller::restoreState(const controlState_t &saved)
+{
+  scheduler.restoreState(saved.scheduler);
+  governor.restoreState(saved.governor);
+  pusher = saved.pusher;
+  state = saved.state;
+  lastTrigger = saved.lastTrigger;
+  lastCycle = saved.lastCycle;
+  lastRevTime_ms = saved.lastRevTime_ms;
+  releaseTime_ms = saved.releaseTime_ms;
+  accelerationTime_ms = saved.accelerationTime_ms;
+  targetRPM = saved.targetRPM;
+  throttle = saved.throttle;
+}
+
+// open loop there's no speed feedback, so with the idle governor the firing delay is cut by
+// how far the last throttle already had the wheels towards full speed
+uint32_t Controller::spinupDelay(uint32_t battery_mv) const
+{
+  uint32_t revThrottle = openLoopThrottle(params.revRPM, battery_mv);
+  if (!adaptiveIdle() || revThrottle == 0)
+  {
+    return params.firingDelay_ms;
+  }
+  uint32_t from = throttle < revThrottle ? throttle : revThrottle;
+  return params.firingDelay_ms * (revThrottle - from) / revThrottle;
+}
+
+uint32_t Controller::openLoopThrottle(uint32_t rpm, uint32_t battery_mv) const
+{
+  if (battery_mv == 0)
+  {
+    return 0; // no reading yet, don't divide by it
+  }
+  uint32_t value = maxThrottle * rpm / battery_mv * 1000 / scaledMotorKv;
+  return value < maxThrottle ? value : maxThrottle;
+}
+
+template <typename Pusher, typename Flywheels>
+void Controller::tickWith(const controlInputs_t &in, controlOutputs_t &out)
+{
+  const tickEvents_t events = {
+      in.time_us,
+      in.time_ms,
+      in.trigger && !lastTrigger,
+      !in.trigger && lastTrigger,
+      in.cycle && !lastCycle,
+      !in.cycle && lastCycle,
+      in.cycle,
+      in.pusherERPM,
+  };
+  uint32_t time_ms = events.time_ms;
+  lastTrigger = in.trigger;
+  lastCycle = in.cycle;
+  out.event = CONTROL_EVENT_NONE;
+
+  if (!in.armed)
+  {
+    // a pull before the ESCs are armed can't fire, and mustn't leave shots queued for later
+    scheduler.cancel();
+  }
+  else if (events.triggerPressed)
+  {
+    scheduler.triggerPressed(events.time_us);
+  }
+  else if (events.triggerReleased)
+  {
+    scheduler.triggerReleased(events.time_us);
+  }
+
+  switch (state)
+  {
+
+  case STATE_IDLE:
+    if (in.armed && (in.trigger || in.rev))
+    {
+      targetRPM = params.revRPM;
+      lastRevTime_ms = time_ms;
+      accelerationTime_ms = spinupDelay(in.battery_mv);
+      if (adaptiveIdle())
+      {
+        governor.engaged(time_ms);
+      }
+      state = STATE_ACCELERATING;
+    }
+    // idle flywheels
+    else if (adaptiveIdle() && releaseTime_ms > 0 && time_ms - releaseTime_ms < governor.holdTime_ms())
+    {
+      targetRPM = governor.idleRPM();
+    }
+    else if (!adaptiveIdle() && time_ms < lastRevTime_ms + params.idleTime_ms && lastRevTime_ms > 0)
+    {
+      targetRPM = params.idleRPM;
+    }
+    // stop flywheels
+    else
+    {
+      targetRPM = 0;
+    }
+    break;
+
+  case STATE_ACCELERATING:
+    if (!Flywheels::openLoop || time_ms > lastRevTime_ms + accelerationTime_ms)
+    {
+      state = STATE_FULLSPEED;
+    }
+    break;
+
+  case STATE_FULLSPEED:
+    if (!in.rev && !scheduler.pending() && !pusher.firing)
+    {
+      state = STATE_IDLE;
+      releaseTime_ms = time_ms;
+      if (adaptiveIdle())
+      {
+        governor.released(time_ms, in.battery_mv);
+      }
+    }
+    else if (scheduler.pending() || pusher.firing)
+    {
+      out.event = Pusher::step(pusher, scheduler, params, events);
+    }
+    break;
+  }
+
+  if (Flywheels::openLoop)
+  {
+    uint32_t target = openLoopThrottle(targetRPM, in.battery_mv);
+    if (throttle == 0)
+    {
+      throttle = target;
+    }
+    else
+    {
+      uint32_t spundown = throttle > params.spindownSpeed ? throttle - params.spindownSpeed : 0;
+      throttle = target > spundown ? target : spundown;
+    }
+  }
+  else
+  {
+    // ray control code goes here
+  }
+
+  out.throttle = throttle;
+  out.pusher = pusher.on;
+  out.pusherBrake = pusher.brake;
+  out.pusherThrottle = pusher.throttle;
+}
+
+Controller::tickFunction_t Controller::tickFunctionFor(pusherType_t pusherType, bool closedLoopFlywheels)
+{
+  static const tickFunction_t variants[][2] = {
+      // open loop, closed loop flywheels
+      {&Controller::tickWith<NoPusher, OpenLoopFlywheels>, &Controller::tickWith<NoPusher, ClosedLoopFlywheels>},             // NO_PUSHER
+      {&Controller::tickWith<MotorPusher, OpenLoopFlywheels>, &Controller::tickWith<MotorPusher, ClosedLoopFlywheels>},       // PUSHER_MOTOR_CLOSEDLOOP
+      {&Controller::tickWith<SolenoidPusher, OpenLoopFlywheels>, &Controller::tickWith<SolenoidPusher, ClosedLoopFlywheels>}, // PUSHER_SOLENOID_OPENLOOP
+      {&Controller::tickWith<BrushlessPusher, OpenLoopFlywheels>, &Controller::tickWith<BrushlessPusher, ClosedLoopFlywheels>}, // PUSHER_BRUSHLESS
+  };
+  uint8_t row = (uint8_t)pusherType < sizeof(variants) / sizeof(variants[0]) ? pusherType : NO_PUSHER;
+  return variants[row][closedLoopFlywheels ? 1 : 0];
+}
+
+uint32_t Controller::wakeTime_us(uint32_t now_us, uint32_t tickEnd_us) const
+{
+  // wake up exactly on the next shot deadline instead of up to a tick late
+  if (state == STATE_FULLSPEED && scheduler.pending())
+  {
+    uint32_t nextShot_us = scheduler.nextShot_us();
+    if ((int32_t)(nextShot_us - now_us) > 0 && (int32_t)(tickEnd_us - nextShot_us) > 0)
+    {
+      return nextShot_us;
+    }
+  }
+  return tickEnd_us;
+}
+
+// every number, in the order they're written, so format and parse can't disagree
+static const size_t controlParamsCount = 24;
+
+static void controlParamsValues(const controlParams_t &params, unsigned values[controlParamsCount])
+{
+  const unsigned ordered[controlParamsCount] = {
+      params.revRPM, params.idleRPM, params.idleTime_ms, params.idleRPMMax, params.idleTimeMin_ms,
+      params.idleActiveGap_ms, params.idleLowBattery_mv, params.motorKv, params.pusherType,
+      params.closedLoopFlywheels, params.firingDelay_ms, params.solenoidExtendTime_ms,
+      params.solenoidRetractTime_ms, params.pusherStallTime_ms, params.spindownSpeed, params.pusherThrottle,
+      params.pusherStrokeERevs, params.pusherBrakeTime_ms, params.fire.mode, params.fire.releaseMode,
+      params.fire.burstLength, params.fire.rateOfFire_dpm, params.fire.rampStartRate_dpm, params.fire.rampTime_ms,
+  };
+  memcpy(values, ordered, sizeof(ordered));
+}
+
+// space separated, 0 when it doesn't fit since a truncated line wouldn't parse anyway
+static size_t formatValues(char *buffer, size_t size, const unsigned *values, size_t count)
+{
+  size_t length = 0;
+  for (size_t i = 0; i < count; i++)
+  {
+    int written = snprintf(buffer + length, size - length, i ? " %u" : "%u", values[i]);
+    if (written < 0 || (size_t)written >= size - length)
+    {
+      return 0;
+    }
+    length += written;
+  }
+  return length;
+}
+
+static bool parseValues(const char *text, unsigned *values, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    char *end;
+    values[i] = strtoul(text, &end, 10);
+    if (end == text)
+    {
+      return false;
+    }
+    text = end;
+  }
+  return true;
+}
+
+size_t controlParamsFormat(char *buffer, size_t size, const controlParams_t &params)
+{
+  unsigned values[controlParamsCount];
+  controlParamsValues(params, values);
+  return formatValues(buffer, size, values, controlParamsCount);
+}
+
+bool controlParamsParse(const char *text, controlParams_t &params)
+{
+  unsigned values[controlParamsCount];
+  if (!parseValues(text, values, controlParamsCount))
+  {
+    return false;
+  }
+  params.revRPM = values[0];
+  params.idleRPM = values[1];
+  params.idleTime_ms = values[2];
+  params.idleRPMMax = values[3];
+  params.idleTimeMin_ms = values[4];
+  params.idleActiveGap_ms = values[5];
+  params.idleLowBattery_mv = values[6];
+  params.motorKv = values[7];
+  params.pusherType = (pusherType_t)values[8];
+  params.closedLoopFlywheels = values[9];
+  params.firingDelay_ms = values[10];
+  params.solenoidExtendTime_ms = values[11];
+  params.solenoidRetractTime_ms = values[12];
+  params.pusherStallTime_ms = values[13];
+  params.spindownSpeed = values[14];
+  params.pusherThrottle = values[15];
+  params.pusherStrokeERevs = values[16];
+  params.pusherBrakeTime_ms = values[17];
+  params.fire.mode = (fireMode_t)values[18];
+  params.fire.releaseMode = (releaseMode_t)values[19];
+  params.fire.burstLength = values[20];
+  params.fire.rateOfFire_dpm = values[21];
+  params.fire.rampStartRate_dpm = values[22];
+  params.fire.rampTime_ms = values[23];
+  return true;
+}
+
+static const size_t controlStateCount = 28;
+
+static void controlStateValues(const controlState_t &state, unsigned values[controlStateCount])
+{
+  const unsigned ordered[controlStateCount] = {
+      state.scheduler.queued, state.scheduler.holding, state.scheduler.hasFired, state.scheduler.paced,
+      state.scheduler.pressTime, state.scheduler.lastShot, state.scheduler.nextShot, state.scheduler.fired,
+      state.governor.averageGap, state.governor.releasedAt_ms, state.governor.releasedOnce, state.governor.rpm,
+      state.governor.hold_ms, state.pusher.firing, state.pusher.on, state.pusher.brake, state.pusher.timer_ms,
+      state.pusher.throttle, state.pusher.position, state.pusher.lastTime_us, state.state, state.lastTrigger,
+      state.lastCycle, state.lastRevTime_ms, state.releaseTime_ms, state.accelerationTime_ms, state.targetRPM,
+      state.throttle,
+  };
+  memcpy(values, ordered, sizeof(ordered));
+}
+
+size_t controlStateFormat(char *buffer, size_t size, const controlState_t &state)
+{
+  unsigned values[controlStateCount];
+  controlStateValues(state, values);
+  return formatValues(buffer, size, values, controlStateCount);
+}
+
+bool controlStateParse(const char *text, controlState_t &state)
+{
+  unsigned values[controlStateCount];
+  if (!parseValues(text, values, controlStateCount))
+  {
+    return false;
+  }
+  state.scheduler.queued = values[0];
+  state.scheduler.holding = values[1];
+  state.scheduler.hasFired = values[2];
+  state.scheduler.paced = values[3];
+  state.scheduler.pressTime = values[4];
+  state.scheduler.lastShot = values[5];
+  state.scheduler.nextShot = values[6];
+  state.scheduler.fired = values[7];
+  state.governor.averageGap = values[8];
+  state.governor.releasedAt_ms = values[9];
+  state.governor.releasedOnce = values[10];
+  state.governor.rpm = values[11];
+  state.governor.hold_ms = values[12];
+  state.pusher.firing = values[13];
+  state.pusher.on = values[14];
+  state.pusher.brake = values[15];
+  state.pusher.timer_ms = values[16];
+  state.pusher.throttle = values[17];
+  state.pusher.position = values[18];
+  state.pusher.lastTime_us = values[19];
+  state.state = (flywheelState_t)values[20];
+  state.lastTrigger = values[21];
+  state.lastCycle = values[22];
+  state.lastRevTime_ms = values[23];
+  state.releaseTime_ms = values[24];
+  state.accelerationTime_ms = values[25];
+  state.targetRPM = values[26];
+  state.throttle = values[27];
+  return true;
+}
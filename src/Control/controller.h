@@ -0,0 +1,161 @@
+#ifndef CONTROLLER_H
+#define CONTROLLER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+#include "FireControl/scheduler.h"
+#include "Control/idleGovernor.h"
+
+// The flywheel and pusher logic, with no hardware access so the same code runs on the
+// blaster and on the host. loop() reads the inputs, calls tick() and drives the outputs.
+//
+// tick() is instantiated once per pusher type and flywheel mode from the policies in
+// firingPolicies.h. configure() picks the instantiation, so a tick never branches on
+// pusherType or closedLoopFlywheels and a new pusher type doesn't touch the others' code.
+
+typedef struct {
+  uint32_t revRPM;
+  uint32_t idleRPM;     // the fixed idle speed, or the floor with the idle governor
+  uint32_t idleTime_ms; // the fixed idle hold, or the longest hold with the idle governor
+  uint32_t idleRPMMax;  // 0 = fixed idle, otherwise the idle governor picks between idleRPM and this
+  uint32_t idleTimeMin_ms;
+  uint32_t idleActiveGap_ms;
+  uint32_t idleLowBattery_mv;
+  uint32_t motorKv;
+  pusherType_t pusherType;
+  bool closedLoopFlywheels;
+  uint16_t firingDelay_ms;
+  uint16_t solenoidExtendTime_ms;
+  uint16_t solenoidRetractTime_ms;
+  uint16_t pusherStallTime_ms;
+  uint16_t spindownSpeed;
+  uint16_t pusherThrottle;     // PUSHER_BRUSHLESS, 0 - 1999
+  uint16_t pusherStrokeERevs;  // PUSHER_BRUSHLESS, electrical revolutions per stroke, pole pairs x gearing
+  uint16_t pusherBrakeTime_ms; // PUSHER_BRUSHLESS, pusherThrottle to stopped with the ESC braking
+  fireConfig_t fire;
+} controlParams_t;
+
+typedef struct {
+  uint32_t time_us;
+  uint32_t time_ms;
+  bool armed;
+  bool rev; // debounced switch states, true = pressed
+  bool trigger;
+  bool cycle;
+  uint32_t battery_mv; // voltage at the ADC, after the voltage divider
+  uint32_t pusherERPM; // from the brushless pusher's ESC telemetry, 0 when there is none
+} controlInputs_t;
+
+enum controlEvent_t {
+  CONTROL_EVENT_NONE,
+  CONTROL_EVENT_SOLENOID_EXTEND,
+  CONTROL_EVENT_SOLENOID_RETRACT,
+  CONTROL_EVENT_PUSHER_STALLED,
+};
+
+typedef struct {
+  uint32_t throttle; // scale is 0 - 1999
+  bool pusher;
+  bool pusherBrake;
+  uint32_t pusherThrottle; // brushless pusher ESC, 0 - 1999, 0 brakes with brake on stop set in the ESC
+  controlEvent_t event;
+} controlOutputs_t;
+
+// input edges and the time, worked out once at the start of a tick for the policies
+typedef struct {
+  uint32_t time_us;
+  uint32_t time_ms;
+  bool triggerPressed; // pressed and released are transitions
+  bool triggerReleased;
+  bool cyclePressed;
+  bool cycleReleased;
+  bool cycle;
+  uint32_t pusherERPM;
+} tickEvents_t;
+
+typedef struct {
+  bool firing; // stroke in progress
+  bool on;     // pusher output
+  bool brake;  // pusher brake output
+  uint32_t timer_ms;
+  uint32_t throttle;    // brushless pusher ESC output
+  uint32_t position;    // brushless pusher, estimated fraction of the stroke done, 65536 is home again
+  uint32_t lastTime_us; // brushless pusher, when position was last advanced
+} pusherState_t;
+
+// everything Controller carries from one tick to the next, with the parameters this is enough
+// to pick up exactly where it was, e.g. replaying a trace that starts mid session
+typedef struct {
+  fireSchedulerState_t scheduler;
+  idleGovernorState_t governor;
+  pusherState_t pusher;
+  flywheelState_t state;
+  bool lastTrigger;
+  bool lastCycle;
+  uint32_t lastRevTime_ms;
+  uint32_t releaseTime_ms;
+  uint32_t accelerationTime_ms;
+  uint32_t targetRPM;
+  uint32_t throttle;
+} controlState_t;
+
+class Controller
+{
+public:
+  static const uint32_t maxThrottle = 1999;
+
+  Controller();
+  void configure(const controlParams_t &params);
+  const controlParams_t &parameters() const { return params; }
+
+  void tick(const controlInputs_t &in, controlOutputs_t &out) { (this->*tickFunction)(in, out); }
+  void reset(); // drop everything in progress and stop, e.g. after the failsafe tripped
+  controlState_t saveState() const;
+  void restoreState(const controlState_t &state); // after configure()
+
+  // when loop() should start its next tick, the end of this tick or the next shot deadline if sooner
+  uint32_t wakeTime_us(uint32_t now_us, uint32_t tickEnd_us) const;
+
+  flywheelState_t flywheelState() const { return state; }
+  bool firing() const { return pusher.firing; }
+  bool idle() const { return state == STATE_IDLE && targetRPM == 0 && throttle == 0 && !pusher.firing && !scheduler.pending(); }
+  uint32_t throttleValue() const { return throttle; }
+  uint32_t openLoopThrottle(uint32_t rpm, uint32_t battery_mv) const;
+  const FireScheduler &fireScheduler() const { return scheduler; }
+  const IdleGovernor &idleGovernor() const { return governor; }
+  uint32_t idleTargetRPM() const { return adaptiveIdle() ? governor.idleRPM() : params.idleRPM; }
+  uint32_t idleHold_ms() const { return adaptiveIdle() ? governor.holdTime_ms() : params.idleTime_ms; }
+
+private:
+  typedef void (Controller::*tickFunction_t)(const controlInputs_t &in, controlOutputs_t &out);
+  template <typename Pusher, typename Flywheels>
+  void tickWith(const controlInputs_t &in, controlOutputs_t &out);
+  static tickFunction_t tickFunctionFor(pusherType_t pusherType, bool closedLoopFlywheels);
+
+  bool adaptiveIdle() const { return params.idleRPMMax > 0; }
+  uint32_t spinupDelay(uint32_t battery_mv) const;
+
+  tickFunction_t tickFunction;
+  controlParams_t params = {};
+  uint32_t scaledMotorKv = 1; // motor kv * battery voltage resistor divider ratio
+  FireScheduler scheduler;
+  IdleGovernor governor;
+  flywheelState_t state = STATE_IDLE;
+  pusherState_t pusher = {};
+  bool lastTrigger = false;
+  bool lastCycle = false;
+  uint32_t lastRevTime_ms = 0; // for calculating idling
+  uint32_t releaseTime_ms = 0; // back to STATE_IDLE, for the idle governor's hold
+  uint32_t accelerationTime_ms = 0;
+  uint32_t targetRPM = 0;
+  uint32_t throttle = 0;
+};
+
+// one line of space separated numbers, used to carry the parameters along with traces
+size_t controlParamsFormat(char *buffer, size_t size, const controlParams_t &params);
+bool controlParamsParse(const char *text, controlParams_t &params);
+size_t controlStateFormat(char *buffer, size_t size, const controlState_t &state);
+bool controlStateParse(const char *text, controlState_t &state);
+
+#endif // CONTROLLER_H
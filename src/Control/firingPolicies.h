@@ -0,0 +1,194 @@
+#ifndef FIRING_POLICIES_H
+#define FIRING_POLICIES_H
+
+#include "Control/controller.h"
+
+// Compile time policies that Controller::tickWith() is instantiated with.
+//
+// A pusher policy has one static step(), called only while the flywheels are at full speed and
+// a shot is pending or a stroke is in progress. It starts and ends strokes through the
+// scheduler and the pusher state and returns the event to report, if any. To add a pusher
+// type, add a policy here and a row in Controller::tickFunctionFor().
+//
+// A flywheel policy says whether the throttle is worked out open loop from the target RPM and
+// battery voltage, with spin up covered by firingDelay_ms, or by a speed controller.
+
+struct NoPusher
+{
+  static controlEvent_t step(pusherState_t &, FireScheduler &, const controlParams_t &, const tickEvents_t &)
+  {
+    return CONTROL_EVENT_NONE;
+  }
+};
+
+// N20 or similar, running until the cycle switch says it's home
+struct MotorPusher
+{
+  static controlEvent_t step(pusherState_t &pusher, FireScheduler &scheduler, const controlParams_t &params,
+                             const tickEvents_t &events)
+  {
+    // start pusher stroke from home once the next shot is due
+    if (scheduler.shotDue(events.time_us) && !pusher.firing)
+    {
+      pusher.on = true;
+      pusher.brake = false;
+      pusher.firing = true;
+      scheduler.shotFired(events.time_us);
+      pusher.timer_ms = events.time_ms;
+    }
+    // back home, keep cycling if the next shot is already due
+    else if (pusher.firing && events.cyclePressed && scheduler.shotDue(events.time_us))
+    {
+      scheduler.shotFired(events.time_us);
+      pusher.timer_ms = events.time_ms;
+    }
+    // back home, brake and wait for the next deadline
+    else if (pusher.firing && events.cyclePressed)
+    {
+      pusher.on = true;
+      pusher.brake = true;
+      pusher.firing = false;
+    }
+    else if (pusher.firing && events.cycleReleased)
+    {
+      pusher.timer_ms = events.time_ms;
+    }
+    // stall protection
+    else if (pusher.firing && events.time_ms > pusher.timer_ms + params.pusherStallTime_ms)
+    {
+      pusher.on = false; // let pusher coast
+      pusher.brake = false;
+      scheduler.cancel();
+      pusher.firing = false;
+      return CONTROL_EVENT_PUSHER_STALLED;
+    }
+    return CONTROL_EVENT_NONE;
+  }
+};
+
+// open loop solenoid, extended and retracted on timers
+struct SolenoidPusher
+{
+  static controlEvent_t step(pusherState_t &pusher, FireScheduler &scheduler, const controlParams_t &params,
+                             const tickEvents_t &events)
+  {
+    // extend solenoid
+    if (scheduler.shotDue(events.time_us) && !pusher.firing && events.time_ms > pusher.timer_ms + params.solenoidRetractTime_ms)
+    {
+      pusher.on = true;
+      pusher.firing = true;
+      scheduler.shotFired(events.time_us);
+      pusher.timer_ms = events.time_ms;
+      return CONTROL_EVENT_SOLENOID_EXTEND;
+    }
+    // retract solenoid
+    else if (pusher.firing && events.time_ms > pusher.timer_ms + params.solenoidExtendTime_ms)
+    {
+      pusher.on = false;
+      pusher.firing = false;
+      pusher.timer_ms = events.time_ms;
+      return CONTROL_EVENT_SOLENOID_RETRACT;
+    }
+    return CONTROL_EVENT_NONE;
+  }
+};
+
+// brushless motor on its own DShot ESC with brake on stop set, so zero throttle brakes it.
+// The cycle switch still marks home, between its edges the stroke position is dead reckoned
+// from the ESC's eRPM telemetry so the motor can be cut early enough to brake to a stop on the
+// switch instead of overrunning it. Without telemetry it brakes when the switch is reached.
+struct BrushlessPusher
+{
+  static const uint32_t stroke = 65536; // position of a full stroke
+
+  static controlEvent_t step(pusherState_t &pusher, FireScheduler &scheduler, const controlParams_t &params,
+                             const tickEvents_t &events)
+  {
+    if (pusher.firing && params.pusherStrokeERevs > 0)
+    {
+      uint64_t advance = (uint64_t)events.pusherERPM * (events.time_us - pusher.lastTime_us) * stroke /
+                         (60000000ULL * params.pusherStrokeERevs);
+      pusher.position = pusher.position + advance < stroke ? pusher.position + (uint32_t)advance : stroke;
+    }
+    pusher.lastTime_us = events.time_us;
+    bool shotDue = scheduler.shotDue(events.time_us);
+
+    // start pusher stroke from home once the next shot is due
+    if (shotDue && !pusher.firing)
+    {
+      pusher.throttle = params.pusherThrottle;
+      pusher.firing = true;
+      pusher.position = 0;
+      scheduler.shotFired(events.time_us);
+      pusher.timer_ms = events.time_ms;
+    }
+    // back home, keep cycling if the next shot is already due
+    else if (pusher.firing && events.cyclePressed && shotDue)
+    {
+      pusher.throttle = params.pusherThrottle;
+      pusher.position = 0;
+      scheduler.shotFired(events.time_us);
+      pusher.timer_ms = events.time_ms;
+    }
+    // back home, brake and wait for the next deadline
+    else if (pusher.firing && events.cyclePressed)
+    {
+      pusher.throttle = 0;
+      pusher.position = 0;
+      pusher.firing = false;
+    }
+    else if (pusher.firing && events.cycleReleased)
+    {
+      pusher.timer_ms = events.time_ms;
+    }
+    // stall protection
+    else if (pusher.firing && events.time_ms > pusher.timer_ms + params.pusherStallTime_ms)
+    {
+      pusher.throttle = 0;
+      scheduler.cancel();
+      pusher.firing = false;
+      return CONTROL_EVENT_PUSHER_STALLED;
+    }
+    else if (pusher.firing && !events.cycle)
+    {
+      pusher.throttle = strokeThrottle(pusher, params, events, shotDue);
+    }
+    return CONTROL_EVENT_NONE;
+  }
+
+  // throttle between leaving home and getting back to it
+  static uint32_t strokeThrottle(const pusherState_t &pusher, const controlParams_t &params, const tickEvents_t &events,
+                                 bool shotDue)
+  {
+    // another shot is coming, run straight through home
+    if (shotDue || params.pusherStrokeERevs == 0)
+    {
+      return params.pusherThrottle;
+    }
+    // braked early but stopped short of the switch, creep the rest of the way
+    if (pusher.throttle == 0 && events.pusherERPM == 0)
+    {
+      return params.pusherThrottle / 4 > 0 ? params.pusherThrottle / 4 : 1;
+    }
+    if (pusher.throttle != params.pusherThrottle)
+    {
+      return pusher.throttle;
+    }
+    // braking slows it roughly linearly, so it covers half of what it would at this speed in the brake time
+    uint64_t lead = (uint64_t)events.pusherERPM * params.pusherBrakeTime_ms * stroke /
+                    (2 * 60000ULL * params.pusherStrokeERevs);
+    return pusher.position + lead >= stroke ? 0 : params.pusherThrottle;
+  }
+};
+
+struct OpenLoopFlywheels
+{
+  static const bool openLoop = true;
+};
+
+struct ClosedLoopFlywheels
+{
+  static const bool openLoop = false;
+};
+
+#endif // FIRING_POLICIES_H
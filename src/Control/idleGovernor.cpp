@@ -0,0 +1,62 @@
+#include <Control/idleGovernor.h>
+
+void IdleGovernor::configure(const idleBounds_t &newBounds)
+{
+  bounds = newBounds;
+  // assume a lull until the player shows otherwise
+  averageGap = bounds.maxHold_ms;
+  releasedOnce = false;
+  rpm = bounds.minRPM;
+  hold_ms = bounds.minHold_ms;
+}
+
+bool IdleGovernor::hasBounds(const idleBounds_t &other) const
+{
+  return bounds.minRPM == other.minRPM && bounds.maxRPM == other.maxRPM && bounds.minHold_ms == other.minHold_ms &&
+         bounds.maxHold_ms == other.maxHold_ms && bounds.activeGap_ms == other.activeGap_ms &&
+         bounds.lowBattery_mv == other.lowBattery_mv;
+}
+
+void IdleGovernor::restoreState(const idleGovernorState_t &state)
+{
+  averageGap = state.averageGap;
+  releasedAt_ms = state.releasedAt_ms;
+  releasedOnce = state.releasedOnce;
+  rpm = state.rpm;
+  hold_ms = state.hold_ms;
+}
+
+void IdleGovernor::engaged(uint32_t time_ms)
+{
+  if (!releasedOnce)
+  {
+    return;
+  }
+  // a very long break counts as one long gap, not as many
+  uint32_t gap = time_ms - releasedAt_ms;
+  uint32_t longest = bounds.maxHold_ms * 4;
+  gap = gap < longest ? gap : longest;
+  averageGap = averageGap - averageGap / 4 + gap / 4;
+}
+
+void IdleGovernor::released(uint32_t time_ms, uint32_t battery_mv)
+{
+  releasedAt_ms = time_ms;
+  releasedOnce = true;
+
+  if (battery_mv < bounds.lowBattery_mv || bounds.maxRPM <= bounds.minRPM)
+  {
+    rpm = bounds.minRPM;
+    hold_ms = bounds.minHold_ms;
+    return;
+  }
+
+  uint32_t gap = averageGap > 1 ? averageGap : 1;
+  uint64_t scaled = (uint64_t)bounds.maxRPM * bounds.activeGap_ms / gap;
+  rpm = scaled < bounds.maxRPM ? (uint32_t)scaled : bounds.maxRPM;
+  rpm = rpm > bounds.minRPM ? rpm : bounds.minRPM;
+
+  uint32_t cover_ms = gap * 2;
+  hold_ms = cover_ms <= bounds.maxHold_ms ? cover_ms : bounds.minHold_ms;
+  hold_ms = hold_ms > bounds.minHold_ms ? hold_ms : bounds.minHold_ms;
+}
@@ -0,0 +1,57 @@
+#ifndef IDLE_GOVERNOR_H
+#define IDLE_GOVERNOR_H
+
+#include <stdint.h>
+
+// Picks the idle RPM and how long to hold it each time the flywheels drop back to idle,
+// from how soon the player has been revving again. Idling costs power roughly with the square
+// of wheel speed, and with open loop spin up time falls roughly linearly with the speed the
+// wheels start from, so the speed that minimises power plus spin up cost is inversely
+// proportional to the expected wait: full idleRPMMax when revs come every activeGap_ms or
+// sooner, tapering to idleRPM as the gaps get longer. The hold covers about two typical gaps,
+// or just the minimum once gaps are longer than the maximum hold anyway.
+
+typedef struct {
+  uint32_t minRPM; // floor, and the idle speed on a low battery
+  uint32_t maxRPM;
+  uint32_t minHold_ms;
+  uint32_t maxHold_ms;
+  uint32_t activeGap_ms;  // gap between revs at or below which idling at maxRPM pays off
+  uint32_t lowBattery_mv; // at the ADC, below this only the floor is used
+} idleBounds_t;
+
+// what the governor carries from one lull to the next
+typedef struct {
+  uint32_t averageGap;
+  uint32_t releasedAt_ms;
+  bool releasedOnce;
+  uint32_t rpm;
+  uint32_t hold_ms;
+} idleGovernorState_t;
+
+class IdleGovernor
+{
+public:
+  void configure(const idleBounds_t &bounds);
+  bool hasBounds(const idleBounds_t &other) const;
+
+  void engaged(uint32_t time_ms);                       // rev started
+  void released(uint32_t time_ms, uint32_t battery_mv); // back to idle, picks the idle for this lull
+
+  uint32_t idleRPM() const { return rpm; }
+  uint32_t holdTime_ms() const { return hold_ms; }
+  uint32_t averageGap_ms() const { return averageGap; }
+
+  idleGovernorState_t saveState() const { return {averageGap, releasedAt_ms, releasedOnce, rpm, hold_ms}; }
+  void restoreState(const idleGovernorState_t &state); // after configure()
+
+private:
+  idleBounds_t bounds = {};
+  uint32_t averageGap = 0; // moving average of release to next rev
+  uint32_t releasedAt_ms = 0;
+  bool releasedOnce = false;
+  uint32_t rpm = 0;
+  uint32_t hold_ms = 0;
+};
+
+#endif // IDLE_GOVERNOR_H
@@ -0,0 +1,139 @@
+#include <Control/latency.h>
+#include <math.h>
+#include <string.h>
+
+void LatencyTracer::clear()
+{
+  memset(histograms, 0, sizeof(histograms));
+  for (latencyHistogram_t &histogram : histograms)
+  {
+    histogram.min_us = UINT32_MAX;
+  }
+  tracking = false;
+  lastTotal = 0;
+  abortedShots = 0;
+  memset(&cycleStats, 0, sizeof(cycleStats));
+  cycleStats.min_us = UINT32_MAX;
+  inVolley = false;
+}
+
+void LatencyTracer::record(latencyPhase_t phase, uint32_t from_us, uint32_t to_us)
+{
+  latencyHistogram_t &histogram = histograms[phase];
+  uint32_t latency_us = to_us - from_us;
+  uint8_t bucket = 0;
+  while (bucket < latencyBucketCount - 1 && latency_us >= latencyBucketBounds_ms[bucket] * 1000UL)
+  {
+    bucket++;
+  }
+  histogram.buckets[bucket]++;
+  histogram.count++;
+  histogram.sum_us += latency_us;
+  histogram.min_us = latency_us < histogram.min_us ? latency_us : histogram.min_us;
+  histogram.max_us = latency_us > histogram.max_us ? latency_us : histogram.max_us;
+}
+
+void LatencyTracer::recordCycle(uint32_t cycle_us)
+{
+  cycleStats.count++;
+  cycleStats.sum_us += cycle_us;
+  cycleStats.sumSquares_us2 += (uint64_t)cycle_us * cycle_us;
+  cycleStats.min_us = cycle_us < cycleStats.min_us ? cycle_us : cycleStats.min_us;
+  cycleStats.max_us = cycle_us > cycleStats.max_us ? cycle_us : cycleStats.max_us;
+}
+
+uint32_t LatencyTracer::cycleStddev_us() const
+{
+  if (cycleStats.count < 2)
+  {
+    return 0;
+  }
+  double mean = (double)cycleStats.sum_us / cycleStats.count;
+  double variance = (double)cycleStats.sumSquares_us2 / cycleStats.count - mean * mean;
+  return variance > 0 ? (uint32_t)sqrt(variance) : 0;
+}
+
+uint32_t LatencyTracer::dartsPerSecond_x10() const
+{
+  return cycleStats.sum_us ? (uint32_t)(cycleStats.count * 10000000ULL / cycleStats.sum_us) : 0;
+}
+
+void LatencyTracer::observe(const controlInputs_t &in, const controlOutputs_t &out, const Controller &controller)
+{
+  uint32_t now_us = in.time_us;
+  bool triggerPressed = in.trigger && !lastTrigger;
+  bool cyclePressed = in.cycle && !lastCycle;
+  bool firingEnded = lastFiring && !controller.firing();
+  lastTrigger = in.trigger;
+  lastCycle = in.cycle;
+  lastFiring = controller.firing();
+
+  // every shot counts here, not just the first of each pull
+  uint32_t fired = controller.fireScheduler().shotsFired();
+  uint32_t firedBefore = lastFired; // before this tick, which may have fired on the trigger edge
+  if (fired != lastFired)
+  {
+    if (inVolley)
+    {
+      recordCycle(now_us - lastShot_us);
+    }
+    inVolley = true;
+    lastShot_us = now_us;
+    lastFired = fired;
+  }
+  else if (!controller.firing() && !controller.fireScheduler().pending())
+  {
+    inVolley = false;
+  }
+
+  // only the first shot of a pull is tagged, later pulls while it's in flight are part of the same wait
+  if (triggerPressed && !tracking)
+  {
+    tracking = true;
+    revved = false;
+    atSpeed = false;
+    pushed = false;
+    trigger_us = now_us;
+    firedAtTrigger = firedBefore;
+  }
+  if (!tracking)
+  {
+    return;
+  }
+
+  // a single tick can cover several steps, e.g. rev already held when the trigger is pulled
+  if (!revved && controller.flywheelState() != STATE_IDLE)
+  {
+    revved = true;
+    rev_us = now_us;
+  }
+  if (revved && !atSpeed && controller.flywheelState() == STATE_FULLSPEED)
+  {
+    atSpeed = true;
+    speed_us = now_us;
+  }
+  if (atSpeed && !pushed && controller.fireScheduler().shotsFired() != firedAtTrigger)
+  {
+    pushed = true;
+    pusher_us = now_us;
+    return; // the stroke can't be complete in the tick it started
+  }
+  if (pushed && (firingEnded || cyclePressed))
+  {
+    record(LATENCY_REV, trigger_us, rev_us);
+    record(LATENCY_SPINUP, rev_us, speed_us);
+    record(LATENCY_FEED, speed_us, pusher_us);
+    record(LATENCY_STROKE, pusher_us, now_us);
+    record(LATENCY_TOTAL, trigger_us, now_us);
+    lastTotal = now_us - trigger_us;
+    tracking = false;
+  }
+  else if (out.event == CONTROL_EVENT_PUSHER_STALLED ||
+           (!pushed && !in.trigger && !controller.fireScheduler().pending()))
+  {
+    // stalled, or let go with no shot coming, whatever the flywheels are doing (e.g. RELEASE_CANCEL,
+    // not armed, or released at full speed with rev still held)
+    abortedShots++;
+    tracking = false;
+  }
+}
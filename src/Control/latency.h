@@ -0,0 +1,84 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <stdint.h>
+#include "Control/controller.h"
+
+// Trigger to shot latency, the number every other change is judged against. The first shot of
+// each trigger pull is tagged at every step on its way out and each step goes into its own
+// histogram, ending when the stroke completes, which is as close to the dart leaving as the
+// blaster can see. Works from the controller's inputs and state after each tick, so it runs
+// the same on the blaster and in the host tools, and never changes what the controller does.
+
+enum latencyPhase_t {
+  LATENCY_REV,    // trigger edge to rev command, the flywheels leaving STATE_IDLE
+  LATENCY_SPINUP, // rev command to STATE_FULLSPEED, firingDelay_ms when open loop
+  LATENCY_FEED,   // at speed to pusher start, waiting on the fire scheduler or the last stroke
+  LATENCY_STROKE, // pusher start to stroke complete, solenoid retracting or N20 back home
+  LATENCY_TOTAL,  // trigger edge to stroke complete
+  LATENCY_PHASE_COUNT,
+};
+
+// bucket upper bounds, the last bucket takes everything longer
+static const uint16_t latencyBucketBounds_ms[] = {1, 2, 5, 10, 20, 50, 100, 200, 500};
+static const uint8_t latencyBucketCount = sizeof(latencyBucketBounds_ms) / sizeof(latencyBucketBounds_ms[0]) + 1;
+
+typedef struct {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+  uint32_t buckets[latencyBucketCount];
+} latencyHistogram_t;
+
+// shot to shot times within a volley, the achieved rate of fire and how steady it is
+typedef struct {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t sum_us;
+  uint64_t sumSquares_us2;
+} cycleStats_t;
+
+class LatencyTracer
+{
+public:
+  LatencyTracer() { clear(); }
+
+  // call after every Controller::tick() with the same inputs and outputs
+  void observe(const controlInputs_t &in, const controlOutputs_t &out, const Controller &controller);
+  void clear();
+
+  const latencyHistogram_t &histogram(latencyPhase_t phase) const { return histograms[phase]; }
+  uint32_t lastTotal_us() const { return lastTotal; }
+  uint32_t aborted() const { return abortedShots; } // trigger pulls that never got a stroke out
+  const cycleStats_t &cycles() const { return cycleStats; }
+  uint32_t cycleStddev_us() const;
+  uint32_t dartsPerSecond_x10() const; // from the mean cycle time, 0 until two shots in a volley
+
+private:
+  void record(latencyPhase_t phase, uint32_t from_us, uint32_t to_us);
+  void recordCycle(uint32_t cycle_us);
+
+  latencyHistogram_t histograms[LATENCY_PHASE_COUNT];
+  bool tracking = false;
+  bool revved = false;
+  bool atSpeed = false;
+  bool pushed = false;
+  bool lastTrigger = false;
+  bool lastCycle = false;
+  bool lastFiring = false;
+  uint32_t firedAtTrigger = 0;
+  uint32_t trigger_us = 0;
+  uint32_t rev_us = 0;
+  uint32_t speed_us = 0;
+  uint32_t pusher_us = 0;
+  uint32_t lastTotal = 0;
+  uint32_t abortedShots = 0;
+  cycleStats_t cycleStats;
+  bool inVolley = false;
+  uint32_t lastFired = 0;
+  uint32_t lastShot_us = 0;
+};
+
+#endif // LATENCY_H
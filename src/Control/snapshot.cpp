@@ -0,0 +1,39 @@
+#include <Control/snapshot.h>
+#include <string.h>
+
+SnapshotChannel controlSnapshot;
+
+void SnapshotChannel::publish(const controlSnapshot_t &snapshot)
+{
+  uint32_t packed[wordCount] = {};
+  memcpy(packed, &snapshot, sizeof(snapshot));
+
+  uint32_t next = sequence.load(std::memory_order_relaxed) + 1;
+  sequence.store(next, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release); // odd sequence is visible before any word changes
+  for (size_t i = 0; i < wordCount; i++)
+  {
+    words[i].store(packed[i], std::memory_order_relaxed);
+  }
+  sequence.store(next + 1, std::memory_order_release);
+}
+
+controlSnapshot_t SnapshotChannel::read() const
+{
+  uint32_t packed[wordCount];
+  uint32_t before, after;
+  do
+  {
+    before = sequence.load(std::memory_order_acquire);
+    for (size_t i = 0; i < wordCount; i++)
+    {
+      packed[i] = words[i].load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_acquire); // words are read before the sequence is checked again
+    after = sequence.load(std::memory_order_relaxed);
+  } while ((before & 1) || before != after);
+
+  controlSnapshot_t snapshot;
+  memcpy(&snapshot, packed, sizeof(snapshot));
+  return snapshot;
+}
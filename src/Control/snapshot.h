@@ -0,0 +1,53 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+// Control state as of the end of one tick. loop() publishes a copy every tick and everything
+// that only watches the blaster (shell, logging, telemetry, the network task) reads that copy
+// instead of the controller, so a reader never sees fields from two different ticks.
+
+typedef struct {
+  uint32_t tick;    // counts published ticks, a reader can tell whether anything changed
+  uint32_t time_us; // when the tick started
+  uint16_t loopTime_us;
+  uint16_t battery_mv; // voltage at the ADC, after the voltage divider
+  uint16_t throttle;   // scale is 0 - 1999
+  uint16_t shotsQueued;
+  uint32_t shotsFired;
+  uint8_t flywheelState; // flywheelState_t
+  bool armed;
+  bool rev;
+  bool trigger;
+  bool cycle;
+  bool pusher;
+  bool pusherBrake;
+  bool firing; // pusher stroke in progress
+  bool idle;   // flywheels stopped and nothing left to fire
+  uint32_t lastLatency_us; // trigger edge to stroke complete for the last tagged shot
+  uint32_t idleRPM;        // what the flywheels idle at after the next release
+  uint32_t idleHold_ms;    // and for how long, when the idle governor is on
+} controlSnapshot_t;
+
+// Single writer seqlock. publish() never waits and costs the same no matter how many readers
+// there are, read() retries while a publish is in progress. The payload is kept in atomic
+// words so a read racing a publish is a retry, not undefined behaviour. Readers run on the
+// other core or in loop() itself, never preempting a publish on the same core.
+class SnapshotChannel
+{
+public:
+  void publish(const controlSnapshot_t &snapshot);
+  controlSnapshot_t read() const;
+
+private:
+  static const size_t wordCount = (sizeof(controlSnapshot_t) + 3) / 4;
+  std::atomic<uint32_t> sequence{0}; // odd while a publish is in progress
+  std::atomic<uint32_t> words[wordCount] = {};
+};
+
+extern SnapshotChannel controlSnapshot;
+
+#endif // SNAPSHOT_H
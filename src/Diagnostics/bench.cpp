@@ -0,0 +1,76 @@
+#include <Diagnostics/bench.h>
+#include <Safety/deadline.h>
+
+static const uint16_t sampleCount = 255; // odd so the median is a sample
+
+static const benchCase_t *benchCases = nullptr;
+static uint8_t benchCaseCount = 0;
+static bool (*benchSafeToRun)() = nullptr;
+static uint32_t samples[sampleCount];
+
+void benchSetCases(const benchCase_t *cases, uint8_t count, bool (*safeToRun)())
+{
+  benchCases = cases;
+  benchCaseCount = count;
+  benchSafeToRun = safeToRun;
+}
+
+static void sortSamples()
+{
+  for (uint16_t i = 1; i < sampleCount; i++)
+  {
+    uint32_t value = samples[i];
+    uint16_t j = i;
+    for (; j > 0 && samples[j - 1] > value; j--)
+    {
+      samples[j] = samples[j - 1];
+    }
+    samples[j] = value;
+  }
+}
+
+static void emptyCase() {}
+
+// returns the median overhead so it can be taken off every other case
+static uint32_t measure(void (*run)(), uint32_t overhead)
+{
+  for (uint16_t i = 0; i < sampleCount; i++)
+  {
+    uint32_t start = ESP.getCycleCount();
+    run();
+    uint32_t cycles = ESP.getCycleCount() - start;
+    samples[i] = cycles > overhead ? cycles - overhead : 0;
+    deadlineKeepAlive(micros()); // the bench holds up loop(), that's expected
+  }
+  sortSamples();
+  return samples[sampleCount / 2];
+}
+
+/**************************************************************/
+/********************* Shell Command Bench ********************/
+/**************************************************************/
+
+int shellCommandBench(int argc, char **argv)
+{
+  if (benchSafeToRun == nullptr || !benchSafeToRun())
+  {
+    shell.println("Motors must be stopped and the pusher idle to run the bench");
+    return -1;
+  }
+  const char *only = argc >= 2 ? argv[1] : nullptr;
+
+  uint32_t overhead = measure(emptyCase, 0);
+  shell.printf("build %s %s, %u MHz, %u samples, %u cycles overhead removed\n",
+               __DATE__, __TIME__, ESP.getCpuFreqMHz(), sampleCount, overhead);
+  shell.printf("%-24s %8s %8s %8s\n", "case", "min", "median", "max");
+  for (uint8_t i = 0; i < benchCaseCount; i++)
+  {
+    if (only != nullptr && strcmp(only, benchCases[i].name) != 0)
+    {
+      continue;
+    }
+    uint32_t median = measure(benchCases[i].run, overhead);
+    shell.printf("%-24s %8u %8u %8u\n", benchCases[i].name, samples[0], median, samples[sampleCount - 1]);
+  }
+  return 0;
+}
@@ -0,0 +1,20 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <Arduino.h>
+#include "SimpleSerialShell.h"
+
+// Cycle counter micro-benchmarks of the primitives the control loop is built from.
+// main.cpp owns the objects being measured, so it supplies the cases.
+
+typedef struct {
+  const char *name;
+  void (*run)();
+} benchCase_t;
+
+extern SimpleSerialShell &shell;
+
+void benchSetCases(const benchCase_t *cases, uint8_t count, bool (*safeToRun)());
+int shellCommandBench(int argc, char **argv);
+
+#endif // BENCH_H
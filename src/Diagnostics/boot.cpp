@@ -0,0 +1,54 @@
+#include <Diagnostics/boot.h>
+
+static const char *const phaseNames[BOOT_PHASE_COUNT] = {
+    "start",
+    "escs",
+    "serial",
+    "inputs",
+    "pusher",
+    "setup",
+    "armed",
+};
+
+static uint32_t phaseTimes_us[BOOT_PHASE_COUNT];
+
+void bootMark(bootPhase_t phase)
+{
+  phaseTimes_us[phase] = micros();
+}
+
+uint32_t bootTime_us(bootPhase_t phase)
+{
+  return phaseTimes_us[phase];
+}
+
+void bootReport(Print &out)
+{
+  uint32_t previous_us = 0;
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++)
+  {
+    if (phaseTimes_us[i] == 0)
+    {
+      out.printf("%-8s pending\n", phaseNames[i]);
+      continue;
+    }
+    out.printf("%-8s %8u us  (+%u us)\n", phaseNames[i], phaseTimes_us[i], phaseTimes_us[i] - previous_us);
+    previous_us = phaseTimes_us[i];
+  }
+  if (phaseTimes_us[BOOT_ARMED] != 0)
+  {
+    uint32_t armed_ms = phaseTimes_us[BOOT_ARMED] / 1000;
+    out.printf("Boot to armed %u ms, target %u ms: %s\n", armed_ms, config->bootTargetArmed_ms,
+               armed_ms <= config->bootTargetArmed_ms ? "PASS" : "FAIL");
+  }
+}
+
+/**************************************************************/
+/********************* Shell Command Boot *********************/
+/**************************************************************/
+
+int shellCommandBoot(int argc, char **argv)
+{
+  bootReport(shell);
+  return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <Arduino.h>
+#include "SimpleSerialShell.h"
+#include "config.h"
+
+// Timestamps for each phase of setup() so boot-to-armed time can be tracked between builds.
+// Times are micros() since the app started, so they don't include the ROM and 2nd stage bootloader.
+
+enum bootPhase_t {
+  BOOT_START,    // entered setup()
+  BOOT_ESCS,     // ESC outputs started, zero throttle is streaming
+  BOOT_SERIAL,   // Serial and shell attached
+  BOOT_INPUTS,   // switches attached
+  BOOT_PUSHER,   // pusher outputs configured
+  BOOT_SETUP,    // setup() returned
+  BOOT_ARMED,    // ESCs have seen escArmTime_ms of zero throttle, blaster can fire
+  BOOT_PHASE_COUNT,
+};
+
+extern SimpleSerialShell &shell;
+
+void bootMark(bootPhase_t phase);
+uint32_t bootTime_us(bootPhase_t phase);
+void bootReport(Print &out);
+int shellCommandBoot(int argc, char **argv);
+
+#endif // BOOT_H
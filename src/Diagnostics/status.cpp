@@ -0,0 +1,73 @@
+#include <Diagnostics/status.h>
+
+static const char *const flywheelStateNames[] = {
+    "idle",         // STATE_IDLE
+    "accelerating", // STATE_ACCELERATING
+    "full speed",   // STATE_FULLSPEED
+};
+
+int shellCommandStatus(int argc, char **argv)
+{
+  controlSnapshot_t status = controlSnapshot.read();
+  shell.printf("tick %u at %u us, loop %u us\n", status.tick, status.time_us, status.loopTime_us);
+  shell.printf("%s, flywheels %s, throttle %u, battery %u mV at the ADC\n", status.armed ? "armed" : "not armed",
+               status.flywheelState < sizeof(flywheelStateNames) / sizeof(flywheelStateNames[0]) ? flywheelStateNames[status.flywheelState] : "?",
+               status.throttle, status.battery_mv);
+  shell.printf("rev %u trigger %u cycle %u\n", status.rev, status.trigger, status.cycle);
+  shell.printf("pusher %u brake %u firing %u, %u queued, %u fired%s\n", status.pusher, status.pusherBrake, status.firing,
+               status.shotsQueued, status.shotsFired, status.idle ? ", idle" : "");
+  shell.printf("last trigger to stroke complete %u us\n", status.lastLatency_us);
+  shell.printf("idle %u rpm for %u ms\n", status.idleRPM, status.idleHold_ms);
+  return 0;
+}
+
+static const char *const latencyPhaseNames[LATENCY_PHASE_COUNT] = {
+    "trigger to rev",      // LATENCY_REV
+    "rev to at speed",     // LATENCY_SPINUP
+    "at speed to pusher",  // LATENCY_FEED
+    "pusher stroke",       // LATENCY_STROKE
+    "trigger to stroke",   // LATENCY_TOTAL
+};
+
+int shellCommandLatency(int argc, char **argv)
+{
+  if (argc >= 2 && strcmp(argv[1], "clear") == 0)
+  {
+    latencyTracer.clear();
+    return 0;
+  }
+
+  shell.printf("%-20s %6s %8s %8s %8s |", "phase, us", "shots", "min", "mean", "max");
+  for (uint8_t i = 0; i < latencyBucketCount - 1; i++)
+  {
+    shell.printf(" <%-4u", latencyBucketBounds_ms[i]);
+  }
+  shell.printf(" more (ms)\n");
+  for (uint8_t phase = 0; phase < LATENCY_PHASE_COUNT; phase++)
+  {
+    const latencyHistogram_t &histogram = latencyTracer.histogram((latencyPhase_t)phase);
+    if (histogram.count == 0)
+    {
+      shell.printf("%-20s %6u\n", latencyPhaseNames[phase], 0);
+      continue;
+    }
+    shell.printf("%-20s %6u %8u %8u %8u |", latencyPhaseNames[phase], histogram.count, histogram.min_us,
+                 (uint32_t)(histogram.sum_us / histogram.count), histogram.max_us);
+    for (uint8_t i = 0; i < latencyBucketCount; i++)
+    {
+      shell.printf(" %5u", histogram.buckets[i]);
+    }
+    shell.println();
+  }
+  shell.printf("%u trigger pulls without a shot\n", latencyTracer.aborted());
+
+  const cycleStats_t &cycles = latencyTracer.cycles();
+  if (cycles.count > 0)
+  {
+    uint32_t dps_x10 = latencyTracer.dartsPerSecond_x10();
+    shell.printf("%-20s %6u %8u %8u %8u | stddev %u us, %u.%u darts/s\n", "shot to shot, us", cycles.count,
+                 cycles.min_us, (uint32_t)(cycles.sum_us / cycles.count), cycles.max_us,
+                 latencyTracer.cycleStddev_us(), dps_x10 / 10, dps_x10 % 10);
+  }
+  return 0;
+}
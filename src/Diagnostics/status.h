@@ -0,0 +1,18 @@
+#ifndef STATUS_H
+#define STATUS_H
+
+#include <Arduino.h>
+#include "SimpleSerialShell.h"
+#include "Control/snapshot.h"
+#include "Control/latency.h"
+
+// Prints the latest control snapshot, never touches the controller itself, and the latency
+// histograms, which are only updated by loop() between shell commands.
+
+extern SimpleSerialShell &shell;
+extern LatencyTracer latencyTracer; // from main.cpp
+
+int shellCommandStatus(int argc, char **argv);
+int shellCommandLatency(int argc, char **argv);
+
+#endif // STATUS_H
@@ -0,0 +1,219 @@
+#include <Diagnostics/trace.h>
+#include "SimpleSerialShell.h"
+#include "Safety/deadline.h"
+
+extern SimpleSerialShell &shell;
+
+static const uint16_t traceLength = 4096; // 32kB, records only come with changes so this is minutes of use
+static const uint16_t recordsPerTick = 16; // the quiet ticks before, every input and output changing, the tick and a failsafe
+
+// enough to replay from a point in the buffer on
+typedef struct {
+  controlState_t state;   // controller after the tick before
+  controlInputs_t inputs; // inputs of the tick before
+  traceOutputs_t outputs; // outputs of the tick before
+  uint16_t offset;        // records before this point, from the start of the trace
+} traceCheckpoint_t;
+
+static traceEvent_t events[traceLength];
+static uint16_t head = 0; // next slot to write
+static uint16_t count = 0;
+static uint32_t dropped = 0;
+static controlParams_t traceParams;
+static traceCheckpoint_t start;  // where the oldest record in the buffer picks up from
+static traceCheckpoint_t middle; // taken once half the buffer is used, the next start
+static bool haveMiddle = false;
+static controlInputs_t last;       // inputs of the last tick
+static traceOutputs_t lastOutputs; // outputs of the last tick
+static bool tickChanged = false;   // something changed this tick, so it gets a record
+static uint16_t quietTicks = 0;    // ticks without changes since the last record
+static uint32_t quietEnd_us = 0;   // the last of them
+static uint32_t quietGap_us = 0;   // between them
+static uint32_t tickGap_us = 0;    // since the tick before
+static const int32_t quietJitter_us = 8; // more than this off the usual gap, e.g. an early wake for a shot, starts a new run
+static const Controller *tracedController = nullptr;
+static bool (*traceIdle)() = nullptr;
+
+static void record(uint32_t time_us, traceEventType_t type, uint16_t value)
+{
+  events[head] = {time_us, (uint8_t)type, value};
+  head = (head + 1) % traceLength;
+  count++;
+}
+
+static void recordQuiet()
+{
+  if (quietTicks > 0)
+  {
+    record(quietEnd_us, TRACE_QUIET, quietTicks);
+    quietTicks = 0;
+  }
+}
+
+void traceStart(const Controller &controller, const controlInputs_t &inputs, const controlOutputs_t &outputs)
+{
+  traceParams = controller.parameters();
+  last = inputs;
+  lastOutputs = {outputs, 0, false};
+  start = {controller.saveState(), last, lastOutputs, 0};
+  haveMiddle = false;
+  tickChanged = false;
+  quietTicks = 0;
+  tracedController = &controller;
+  head = 0;
+  count = 0;
+  dropped = 0;
+}
+
+void traceSetIdleCheck(bool (*idle)())
+{
+  traceIdle = idle;
+}
+
+void traceFailsafe(uint32_t time_us)
+{
+  if (tracedController != nullptr)
+  {
+    recordQuiet();
+    record(time_us, TRACE_FAILSAFE, 0);
+    lastOutputs = {};
+  }
+}
+
+void traceInputs(const controlInputs_t &inputs, const Controller &controller)
+{
+  // between ticks here, so the controller's state lines up with the records
+  if (count + recordsPerTick > traceLength && haveMiddle)
+  {
+    dropped += middle.offset;
+    count -= middle.offset;
+    start = middle;
+    start.offset = 0;
+    haveMiddle = false;
+  }
+  if (count >= traceLength / 2 && !haveMiddle)
+  {
+    recordQuiet();
+    middle = {controller.saveState(), last, lastOutputs, count};
+    haveMiddle = true;
+  }
+
+  const uint32_t values[] = {inputs.armed, inputs.rev, inputs.trigger, inputs.cycle, inputs.battery_mv,
+                             inputs.pusherERPM / 100};
+  const uint32_t lastValues[] = {last.armed, last.rev, last.trigger, last.cycle, last.battery_mv,
+                                 last.pusherERPM / 100};
+  static const traceEventType_t types[] = {TRACE_ARMED,   TRACE_REV,     TRACE_TRIGGER,
+                                           TRACE_CYCLE,   TRACE_BATTERY, TRACE_PUSHER_ERPM};
+  tickChanged = false;
+  for (int i = 0; i < 6; i++)
+  {
+    if (values[i] != lastValues[i])
+    {
+      if (!tickChanged)
+      {
+        recordQuiet();
+        tickChanged = true;
+      }
+      record(inputs.time_us, types[i], values[i]);
+    }
+  }
+  tickGap_us = inputs.time_us - last.time_us;
+  last = inputs;
+}
+
+void traceOutputs(const controlOutputs_t &outputs)
+{
+  if (tracedController == nullptr)
+  {
+    return;
+  }
+  const controlOutputs_t &before = lastOutputs.outputs;
+  int32_t throttleStep = (int32_t)(outputs.throttle - before.throttle);
+  const bool changed[] = {throttleStep != lastOutputs.throttleStep, outputs.pusher != before.pusher,
+                          outputs.pusherBrake != before.pusherBrake, outputs.pusherThrottle != before.pusherThrottle};
+  const uint32_t values[] = {outputs.throttle, outputs.pusher, outputs.pusherBrake, outputs.pusherThrottle};
+  static const traceEventType_t types[] = {TRACE_THROTTLE, TRACE_PUSHER, TRACE_BRAKE, TRACE_PUSHER_THROTTLE};
+  for (int i = 0; i < 4; i++)
+  {
+    if (changed[i])
+    {
+      if (!tickChanged)
+      {
+        recordQuiet();
+        tickChanged = true;
+      }
+      record(last.time_us, types[i], values[i]);
+    }
+  }
+  lastOutputs = {outputs, throttleStep, false};
+
+  if (tickChanged)
+  {
+    record(last.time_us, TRACE_TICK, (uint16_t)last.time_ms);
+  }
+  else
+  {
+    // replay spreads a run evenly, so keep them to ticks about as far apart
+    int32_t offGap_us = (int32_t)(tickGap_us - quietGap_us);
+    if (quietTicks > 0 && (offGap_us > quietJitter_us || offGap_us < -quietJitter_us))
+    {
+      recordQuiet();
+    }
+    quietTicks++;
+    quietEnd_us = last.time_us;
+    quietGap_us = tickGap_us;
+    if (quietTicks == UINT16_MAX)
+    {
+      recordQuiet();
+    }
+  }
+}
+
+/**************************************************************/
+/********************* Shell Command Trace ********************/
+/**************************************************************/
+
+int shellCommandTrace(int argc, char **argv)
+{
+  if (argc >= 2 && strcmp(argv[1], "dump") == 0)
+  {
+    if (traceIdle == nullptr || !traceIdle())
+    {
+      shell.println("Motors must be stopped and the pusher idle to dump the trace");
+      return -1;
+    }
+    char line[320];
+    shell.printf("trace %u\n", traceVersion);
+    controlParamsFormat(line, sizeof(line), traceParams);
+    shell.printf("params %s\n", line);
+    controlStateFormat(line, sizeof(line), start.state);
+    shell.printf("state %s\n", line);
+    const controlInputs_t &inputs = start.inputs;
+    shell.printf("start %u %u %u %u %u %u %u %u\n", inputs.time_us, inputs.time_ms, inputs.armed, inputs.rev,
+                 inputs.trigger, inputs.cycle, inputs.battery_mv, inputs.pusherERPM);
+    const controlOutputs_t &outputs = start.outputs.outputs;
+    shell.printf("outputs %u %u %u %u %d\n", outputs.throttle, outputs.pusher, outputs.pusherBrake,
+                 outputs.pusherThrottle, start.outputs.throttleStep);
+    uint16_t oldest = (head + traceLength - count) % traceLength;
+    for (uint16_t i = 0; i < count; i++)
+    {
+      const traceEvent_t &event = events[(oldest + i) % traceLength];
+      shell.printf("e %u %u %u\n", event.time_us, event.type, event.value);
+      deadlineKeepAlive(micros()); // waiting on Serial, safe since the blaster is idle
+    }
+    if (quietTicks > 0)
+    {
+      shell.printf("e %u %u %u\n", quietEnd_us, TRACE_QUIET, quietTicks);
+    }
+  }
+  else if (argc >= 2 && strcmp(argv[1], "clear") == 0 && tracedController != nullptr)
+  {
+    traceStart(*tracedController, last, lastOutputs.outputs);
+  }
+  else
+  {
+    shell.printf("%u of %u records, %u dropped, %u quiet ticks\n", count, traceLength, dropped, quietTicks);
+    shell.println("trace [dump|clear]");
+  }
+  return 0;
+}
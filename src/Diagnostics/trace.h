@@ -0,0 +1,138 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include "Control/controller.h"
+
+// Input trace recorder. Every change to the controller's inputs and outputs is kept in a RAM
+// buffer along with when the controller ticked, and can be dumped over the shell, then replayed
+// through the same Controller on the host with tools/replay to get the output sequence back.
+//
+// Only ticks where an input or output changed get a record of their own. The quiet ticks in
+// between are counted and replayed evenly spaced up to the last one, so an idle blaster costs
+// a record every minute or so instead of one per tick. Throttle ramps count as quiet while the
+// step per tick stays the same. Replay checks its outputs against the recorded ones on every
+// tick, quiet or not, and says so if they differ.
+//
+// The trace starts from a checkpoint of the controller's state, so it can begin mid session.
+// Once the buffer fills, the older half is dropped and the trace starts from the checkpoint
+// taken when the buffer was half full.
+//
+// Dump format, one record per line:
+//   trace <version>
+//   params <controlParamsFormat()>
+//   state <controlStateFormat()>
+//   start <time_us> <time_ms> <armed> <rev> <trigger> <cycle> <battery_mv> <pusherERPM>
+//   outputs <throttle> <pusher> <brake> <pusherThrottle> <throttleStep>
+//   e <time_us> <traceEventType_t> <value>
+// Input and output changes apply to the next TRACE_TICK, which is when the controller ticked.
+
+static const uint16_t traceVersion = 6;
+
+enum traceEventType_t {
+  TRACE_ARMED,
+  TRACE_REV,
+  TRACE_TRIGGER,
+  TRACE_CYCLE,
+  TRACE_BATTERY,
+  TRACE_PUSHER_ERPM, // in hundreds, the resolution ESC telemetry has anyway
+  TRACE_TICK,        // value is the low 16 bits of time_ms, the tick before has the rest
+  TRACE_FAILSAFE,    // the failsafe tripped and the controller was reset
+  TRACE_QUIET,       // value quiet ticks since the last tick, time_us is the last of them
+  TRACE_THROTTLE,    // outputs after the tick, the throttle only when its step changed
+  TRACE_PUSHER,
+  TRACE_BRAKE,
+  TRACE_PUSHER_THROTTLE,
+};
+
+typedef struct {
+  uint32_t time_us;
+  uint8_t type;
+  uint16_t value;
+} traceEvent_t;
+
+// the outputs as recorded
+typedef struct {
+  controlOutputs_t outputs;
+  int32_t throttleStep;  // the throttle moves this much every tick without a TRACE_THROTTLE
+  bool throttleRecorded; // the tick so far has a TRACE_THROTTLE
+} traceOutputs_t;
+
+// returns false for records that aren't outputs
+static inline bool traceApplyOutput(traceOutputs_t &recorded, const traceEvent_t &event)
+{
+  switch (event.type)
+  {
+  case TRACE_THROTTLE:
+    recorded.throttleStep = (int32_t)(event.value - recorded.outputs.throttle);
+    recorded.outputs.throttle = event.value;
+    recorded.throttleRecorded = true;
+    return true;
+  case TRACE_PUSHER:
+    recorded.outputs.pusher = event.value;
+    return true;
+  case TRACE_BRAKE:
+    recorded.outputs.pusherBrake = event.value;
+    return true;
+  case TRACE_PUSHER_THROTTLE:
+    recorded.outputs.pusherThrottle = event.value;
+    return true;
+  }
+  return false;
+}
+
+// at every tick once its records are applied, quiet ones included
+static inline void traceOutputsTicked(traceOutputs_t &recorded)
+{
+  if (!recorded.throttleRecorded)
+  {
+    recorded.outputs.throttle += recorded.throttleStep;
+  }
+  recorded.throttleRecorded = false;
+}
+
+static inline void traceApplyEvent(controlInputs_t &inputs, const traceEvent_t &event)
+{
+  switch (event.type)
+  {
+  case TRACE_ARMED:
+    inputs.armed = event.value;
+    break;
+  case TRACE_REV:
+    inputs.rev = event.value;
+    break;
+  case TRACE_TRIGGER:
+    inputs.trigger = event.value;
+    break;
+  case TRACE_CYCLE:
+    inputs.cycle = event.value;
+    break;
+  case TRACE_BATTERY:
+    inputs.battery_mv = event.value;
+    break;
+  case TRACE_PUSHER_ERPM:
+    inputs.pusherERPM = event.value * 100UL;
+    break;
+  case TRACE_TICK:
+    inputs.time_ms += (uint16_t)(event.value - (uint16_t)inputs.time_ms);
+    break;
+  }
+  inputs.time_us = event.time_us;
+}
+
+// restarts the trace, needed whenever the params change so the trace carries the ones in use.
+// Called between ticks, with the inputs and outputs of the last tick.
+void traceStart(const Controller &controller, const controlInputs_t &inputs, const controlOutputs_t &outputs);
+// called once per tick just before controller.tick(), records the inputs that changed since the last tick
+void traceInputs(const controlInputs_t &inputs, const Controller &controller);
+// and just after, records the outputs that changed and the tick if anything did
+void traceOutputs(const controlOutputs_t &outputs);
+// called after the controller was reset by the failsafe
+void traceFailsafe(uint32_t time_us);
+
+// dumping holds up loop() for a while, so it's only allowed while this says the blaster is idle
+void traceSetIdleCheck(bool (*idle)());
+
+int shellCommandTrace(int argc, char **argv);
+
+#endif // TRACE_H
@@ -0,0 +1,111 @@
+#include <Esc/analogEsc.h>
+
+static const ledc_mode_t speedMode = LEDC_HIGH_SPEED_MODE;
+static const ledc_timer_t escTimer = LEDC_TIMER_0;
+static const uint32_t ledcClock_hz = 80000000; // APB clock
+static const uint32_t maxThrottle = 1999;
+static const uint32_t pulseGuard_us = 5; // for micros() and interrupts between a pulse ending and us seeing it
+
+typedef struct {
+  uint32_t minPulse_ns;
+  uint32_t maxPulse_ns;
+  uint32_t maxRate_hz;
+} analogProtocol_t;
+
+// indexed by analogMode_t
+static const analogProtocol_t protocols[] = {
+    {1000000, 2000000, 490}, // ANALOG_PWM
+    {125000, 250000, 4000},  // ANALOG_ONESHOT125
+    {41667, 83333, 12000},   // ANALOG_ONESHOT42
+    {5000, 25000, 32000},    // ANALOG_MULTISHOT
+};
+
+uint32_t AnalogEsc::begin(analogMode_t mode, uint32_t updateRate_hz, const int8_t *pins, uint8_t count)
+{
+  const analogProtocol_t &protocol = protocols[mode];
+  uint32_t tick_us = 1000000 / updateRate_hz;
+  minFrame_us = max(1000000 / protocol.maxRate_hz, protocol.maxPulse_ns / 1000 + pulseGuard_us);
+  uint32_t ticksPerFrame = (minFrame_us + tick_us - 1) / tick_us;
+  // a quarter tick of slack so a slightly late tick still restarts the timer before it wraps
+  uint32_t timerPeriod_us = ticksPerFrame * tick_us + tick_us / 4;
+  uint32_t rate_hz = 1000000 / timerPeriod_us;
+  period_ns = 1000000000UL / rate_hz;
+  minPulse_ns = protocol.minPulse_ns;
+  pulseRange_ns = protocol.maxPulse_ns - protocol.minPulse_ns;
+
+  // highest resolution the 80MHz clock supports at this rate, capped at 16 bits
+  resolution_bits = 1;
+  while (resolution_bits < 16 && ((uint64_t)rate_hz << (resolution_bits + 1)) <= ledcClock_hz)
+  {
+    resolution_bits++;
+  }
+
+  ledc_timer_config_t timerConfig = {};
+  timerConfig.speed_mode = speedMode;
+  timerConfig.duty_resolution = (ledc_timer_bit_t)resolution_bits;
+  timerConfig.timer_num = escTimer;
+  timerConfig.freq_hz = rate_hz;
+  timerConfig.clk_cfg = LEDC_USE_APB_CLK;
+  ledc_timer_config(&timerConfig);
+
+  channels = count < maxChannels ? count : maxChannels;
+  for (uint8_t i = 0; i < channels; i++)
+  {
+    ledc_channel_config_t channelConfig = {};
+    channelConfig.gpio_num = pins[i];
+    channelConfig.speed_mode = speedMode;
+    channelConfig.channel = (ledc_channel_t)i;
+    channelConfig.timer_sel = escTimer;
+    channelConfig.duty = 0;
+    channelConfig.hpoint = 0;
+    ledc_channel_config(&channelConfig);
+    set(i, 0); // ESCs arm on a minimum throttle signal, not on no signal
+  }
+  startFrame();
+  return 1000000 / (ticksPerFrame * tick_us);
+}
+
+void AnalogEsc::set(uint8_t channel, uint32_t throttle)
+{
+  if (channel >= channels)
+  {
+    return;
+  }
+  uint32_t pulse_ns = minPulse_ns + pulseRange_ns * min(throttle, maxThrottle) / maxThrottle;
+  uint32_t duty = ((uint64_t)pulse_ns << resolution_bits) / period_ns;
+  ledc_set_duty(speedMode, (ledc_channel_t)channel, duty);
+}
+
+void AnalogEsc::stop()
+{
+  for (uint8_t i = 0; i < channels; i++)
+  {
+    ledc_stop(speedMode, (ledc_channel_t)i, 0);
+  }
+}
+
+void AnalogEsc::update()
+{
+  // where the timer is in its period, it has wrapped by itself if a tick was late
+  uint32_t phase_us = (micros() - frameStart_us) % (period_ns / 1000);
+  if (phase_us >= minFrame_us)
+  {
+    startFrame();
+  }
+}
+
+void AnalogEsc::startFrame()
+{
+  // the last pulse has ended, so holding the timer doesn't stretch one
+  ledc_timer_pause(speedMode, escTimer);
+  // only marks each channel's new duty to be taken on at the start of a period, which also
+  // turns a stopped output back on
+  for (uint8_t i = 0; i < channels; i++)
+  {
+    ledc_update_duty(speedMode, (ledc_channel_t)i);
+  }
+  // a new period for every channel at once, with all the new duties
+  ledc_timer_rst(speedMode, escTimer);
+  ledc_timer_resume(speedMode, escTimer);
+  frameStart_us = micros();
+}
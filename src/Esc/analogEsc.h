@@ -0,0 +1,46 @@
+#ifndef ANALOG_ESC_H
+#define ANALOG_ESC_H
+
+#include <Arduino.h>
+#include <driver/ledc.h>
+
+// Analog ESC output used when dshotMode == DSHOT_OFF.
+// All channels run off one LEDC timer so their pulses start together. update() restarts the
+// timer with every channel's new duty latched at once, so each tick's throttle goes out right
+// away instead of whenever a free running timer next wraps. When the last pulse is still going
+// or the protocol's frame rate wouldn't allow another yet, the new duties wait for a later tick.
+// The timer period is a little longer than the ticks between frames, so it only wraps and
+// repeats the last frame by itself when a tick is late, or before loop() starts.
+
+enum analogMode_t {
+  ANALOG_PWM,        // 1000-2000us, up to 490Hz
+  ANALOG_ONESHOT125, // 125-250us, up to 4kHz
+  ANALOG_ONESHOT42,  // 42-84us, up to 12kHz
+  ANALOG_MULTISHOT,  // 5-25us, up to 32kHz
+};
+
+class AnalogEsc
+{
+public:
+  static const uint8_t maxChannels = 8; // LEDC high speed channels
+
+  // returns the frame rate actually used, the update rate or a whole fraction of it that
+  // the protocol allows
+  uint32_t begin(analogMode_t mode, uint32_t updateRate_hz, const int8_t *pins, uint8_t count);
+  void set(uint8_t channel, uint32_t throttle); // throttle scale is 0 - 1999, like DShot
+  void update();                                // start a frame with every channel's new duty, if one may start now
+  void stop();                                  // holds every output low until the next update()
+
+private:
+  void startFrame();
+
+  uint8_t channels = 0;
+  uint32_t period_ns = 0;   // of the timer
+  uint32_t minFrame_us = 0; // shortest time from one frame start to the next
+  uint32_t frameStart_us = 0;
+  uint32_t minPulse_ns = 0;
+  uint32_t pulseRange_ns = 0;
+  uint8_t resolution_bits = 0;
+};
+
+#endif // ANALOG_ESC_H
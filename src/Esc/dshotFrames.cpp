@@ -0,0 +1,58 @@
+#include <Esc/dshotFrames.h>
+
+static uint32_t rmtItem(uint32_t high_ticks, uint32_t low_ticks)
+{
+  return (high_ticks & 0x7fff) | (1UL << 15) | ((low_ticks & 0x7fff) << 16);
+}
+
+uint16_t dshotPacket(uint16_t value, bool telemetry)
+{
+  bool command = value > 0 && value <= dshotCommandMax;
+  uint16_t packet = (value << 1) | (telemetry || command ? 1 : 0);
+  uint16_t crc = (packet ^ (packet >> 4) ^ (packet >> 8)) & 0x0f;
+  return (packet << 4) | crc;
+}
+
+void DshotFrames::configure(uint32_t bitrate_kbps, uint32_t rmtClock_hz)
+{
+  // a one is high for 3/4 of the bit, a zero for 3/8
+  uint32_t bit_ticks = rmtClock_hz / (bitrate_kbps * 1000);
+  uint32_t oneHigh_ticks = bit_ticks * 3 / 4;
+  uint32_t zeroHigh_ticks = bit_ticks * 3 / 8;
+  oneItem = rmtItem(oneHigh_ticks, bit_ticks - oneHigh_ticks);
+  zeroItem = rmtItem(zeroHigh_ticks, bit_ticks - zeroHigh_ticks);
+}
+
+void DshotFrames::encode(uint16_t value, bool telemetry, dshotFrame_t &frame) const
+{
+  uint16_t packet = dshotPacket(value, telemetry);
+  for (uint8_t bit = 0; bit < 16; bit++)
+  {
+    frame.items[bit] = (packet & (0x8000 >> bit)) ? oneItem : zeroItem;
+  }
+  frame.items[16] = 0; // end marker
+}
+
+uint8_t DshotFrames::prepare(const uint16_t *values, uint8_t count)
+{
+  uint8_t encoded = 0;
+  for (uint8_t motor = 0; motor < count && motor < maxMotors; motor++)
+  {
+    // flywheels mostly share one throttle, so usually only the first motor gets encoded
+    uint8_t shared = 0;
+    while (shared < encoded && frameValues[shared] != values[motor])
+    {
+      shared++;
+    }
+    frameOf[motor] = shared;
+    if (shared < encoded)
+    {
+      continue;
+    }
+
+    encode(values[motor], false, frames[encoded]);
+    frameValues[encoded] = values[motor];
+    encoded++;
+  }
+  return encoded;
+}
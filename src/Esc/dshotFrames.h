@@ -0,0 +1,42 @@
+#ifndef DSHOT_FRAMES_H
+#define DSHOT_FRAMES_H
+
+#include <stdint.h>
+#include "types.h"
+
+// DShot frame encoding for the motor array, with no hardware access so the per-tick cost can be
+// measured on the host. A frame is 16 RMT items, one per bit, plus an end marker, in the
+// ESP32's RMT item layout: duration0:15 level0:1 duration1:15 level1:1.
+
+static const uint8_t dshotFrameItems = 17;
+
+typedef struct {
+  uint32_t items[dshotFrameItems];
+} dshotFrame_t;
+
+static const uint16_t dshotCommandMax = 47; // 1 - 47 are commands, 0 is motor stop
+
+// 11 bit value, 48 - 2047 is throttle and below 48 are commands, telemetry request bit, 4 bit CRC.
+// Commands always go out with the telemetry bit set, BLHeli_32 and AM32 ignore them otherwise.
+uint16_t dshotPacket(uint16_t value, bool telemetry);
+
+class DshotFrames
+{
+public:
+  void configure(uint32_t bitrate_kbps, uint32_t rmtClock_hz);
+
+  // encodes each motor's value, motors sharing a value share one encoding, returns how many were encoded
+  uint8_t prepare(const uint16_t *values, uint8_t count);
+  const dshotFrame_t &frame(uint8_t motor) const { return frames[frameOf[motor]]; }
+  // a one off frame outside the shared set, e.g. the pusher's with its telemetry request
+  void encode(uint16_t value, bool telemetry, dshotFrame_t &frame) const;
+
+private:
+  uint32_t oneItem = 0;
+  uint32_t zeroItem = 0;
+  dshotFrame_t frames[maxMotors];
+  uint16_t frameValues[maxMotors];
+  uint8_t frameOf[maxMotors] = {};
+};
+
+#endif // DSHOT_FRAMES_H
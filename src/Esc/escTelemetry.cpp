@@ -0,0 +1,50 @@
+#include <Esc/escTelemetry.h>
+#include <string.h>
+
+uint8_t escTelemetryCrc(const uint8_t *bytes, uint8_t length)
+{
+  // CRC-8, polynomial 0x07
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < length; i++)
+  {
+    crc ^= bytes[i];
+    for (uint8_t bit = 0; bit < 8; bit++)
+    {
+      crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+bool EscTelemetry::feed(uint8_t byte, uint32_t time_us)
+{
+  window[length++] = byte;
+  if (length < escTelemetryFrameLength)
+  {
+    return false;
+  }
+
+  if (escTelemetryCrc(window, escTelemetryFrameLength - 1) != window[escTelemetryFrameLength - 1])
+  {
+    // out of step, slide along a byte and try again
+    badFrames++;
+    memmove(window, window + 1, escTelemetryFrameLength - 1);
+    length--;
+    return false;
+  }
+  reading.temperature_c = window[0];
+  reading.voltage_cv = (window[1] << 8) | window[2];
+  reading.current_ca = (window[3] << 8) | window[4];
+  reading.consumption_mah = (window[5] << 8) | window[6];
+  reading.eRPM = ((window[7] << 8) | window[8]) * 100UL;
+  lastFrame_us = time_us;
+  haveFrame = true;
+  goodFrames++;
+  length = 0;
+  return true;
+}
+
+uint32_t EscTelemetry::eRPM(uint32_t time_us, uint32_t stale_us) const
+{
+  return haveFrame && time_us - lastFrame_us <= stale_us ? reading.eRPM : 0;
+}
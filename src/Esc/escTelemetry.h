@@ -0,0 +1,45 @@
+#ifndef ESC_TELEMETRY_H
+#define ESC_TELEMETRY_H
+
+#include <stdint.h>
+
+// KISS / BLHeli_32 serial telemetry, the 10 byte frame an ESC sends on its telemetry wire at
+// 115200 baud after a DShot frame with the telemetry bit set. No hardware access, loop() feeds
+// it whatever bytes have arrived, in batches, so there's no timing to find frame boundaries by.
+// Frames are found by their CRC in a sliding window instead, so a byte lost on the wire costs a
+// reading or two and then it's back in step.
+
+static const uint8_t escTelemetryFrameLength = 10;
+
+typedef struct {
+  uint8_t temperature_c;
+  uint16_t voltage_cv;   // 10mV
+  uint16_t current_ca;   // 10mA
+  uint16_t consumption_mah;
+  uint32_t eRPM;
+} escTelemetry_t;
+
+uint8_t escTelemetryCrc(const uint8_t *bytes, uint8_t length);
+
+class EscTelemetry
+{
+public:
+  // returns true when the byte completed a frame, time_us is when it was read
+  bool feed(uint8_t byte, uint32_t time_us);
+  const escTelemetry_t &last() const { return reading; }
+  // 0 once the last frame is older than stale_us, e.g. the ESC stopped answering
+  uint32_t eRPM(uint32_t time_us, uint32_t stale_us) const;
+  uint32_t frames() const { return goodFrames; }
+  uint32_t errors() const { return badFrames; }
+
+private:
+  uint8_t window[escTelemetryFrameLength];
+  uint8_t length = 0;
+  uint32_t lastFrame_us = 0;
+  bool haveFrame = false;
+  escTelemetry_t reading = {};
+  uint32_t goodFrames = 0;
+  uint32_t badFrames = 0; // windows dropped for a bad CRC
+};
+
+#endif // ESC_TELEMETRY_H
@@ -0,0 +1,141 @@
+#include <Esc/motors.h>
+
+static const uint32_t rmtClock_hz = 80000000; // APB clock, divider 1
+static const uint16_t dshotThrottleOffset = 48; // values below are commands
+static const uint16_t dshotSpinDirectionNormal = 20;
+static const uint16_t dshotSpinDirectionReversed = 21;
+
+// indexed by dshot_mode_t
+static const uint16_t dshotBitrates_kbps[] = {
+    0,    // DSHOT_OFF
+    150,  // DSHOT150
+    300,  // DSHOT300
+    600,  // DSHOT600
+    1200, // DSHOT1200
+};
+
+static void rmtBegin(uint8_t channel, int8_t pin)
+{
+  rmt_config_t rmtConfig = {};
+  rmtConfig.rmt_mode = RMT_MODE_TX;
+  rmtConfig.channel = (rmt_channel_t)channel;
+  rmtConfig.gpio_num = (gpio_num_t)pin;
+  rmtConfig.clk_div = 1;
+  rmtConfig.mem_block_num = 1; // 64 items, a frame is 17
+  rmtConfig.tx_config.idle_output_en = true;
+  rmtConfig.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+  rmt_config(&rmtConfig);
+  rmt_driver_install((rmt_channel_t)channel, 0, 0);
+}
+
+uint8_t MotorArray::begin(const int8_t *pins, int8_t pusherPin, dshot_mode_t dshotMode, analogMode_t analogMode,
+                          uint32_t updateRate_hz)
+{
+  motors = 0;
+  while (motors < maxMotors && pins[motors] != 0)
+  {
+    targets_pct[motors] = 100;
+    motors++;
+  }
+  dshot = dshotMode != DSHOT_OFF;
+
+  if (!dshot)
+  {
+    analogRate = analog.begin(analogMode, updateRate_hz, pins, motors);
+    return motors;
+  }
+
+  frames.configure(dshotBitrates_kbps[dshotMode], rmtClock_hz);
+  for (uint8_t i = 0; i < motors; i++)
+  {
+    rmtBegin(i, pins[i]);
+  }
+  // there are as many RMT channels as maxMotors, so eight flywheels leave none for the pusher
+  pusher = pusherPin != 0 && motors < maxMotors;
+  if (pusher)
+  {
+    rmtBegin(motors, pusherPin);
+  }
+  update(0);
+  return motors;
+}
+
+void MotorArray::setTargets(const uint8_t *target_pct)
+{
+  for (uint8_t i = 0; i < motors; i++)
+  {
+    targets_pct[i] = target_pct[i] < 100 ? target_pct[i] : 100;
+  }
+}
+
+void MotorArray::setDirections(uint8_t reversedMask)
+{
+  reversed = reversedMask;
+  directionFrames = dshot && reversed ? directionCommandRepeats : 0;
+}
+
+void MotorArray::stop()
+{
+  if (!dshot)
+  {
+    analog.stop();
+    return;
+  }
+  for (uint8_t i = 0; i < motors + (pusher ? 1 : 0); i++)
+  {
+    rmt_tx_stop((rmt_channel_t)i); // the line drops to its idle level, low
+  }
+}
+
+void MotorArray::setPusher(uint32_t throttle, bool requestTelemetry)
+{
+  pusherValue = throttle > 0 ? throttle + dshotThrottleOffset : 0;
+  pusherTelemetry = requestTelemetry;
+}
+
+void MotorArray::update(uint32_t throttle)
+{
+  if (!dshot)
+  {
+    for (uint8_t i = 0; i < motors; i++)
+    {
+      analog.set(i, throttle * targets_pct[i] / 100);
+    }
+    analog.update();
+    return;
+  }
+
+  uint16_t values[maxMotors];
+  bool directionCommand = throttle == 0 && directionFrames > 0;
+  for (uint8_t i = 0; i < motors; i++)
+  {
+    if (directionCommand)
+    {
+      values[i] = reversed & (1 << i) ? dshotSpinDirectionReversed : dshotSpinDirectionNormal;
+    }
+    else
+    {
+      values[i] = throttle * targets_pct[i] / 100 + dshotThrottleOffset;
+    }
+  }
+  if (directionCommand)
+  {
+    directionFrames--;
+  }
+
+  frames.prepare(values, motors);
+  // load every channel first so the starts below are only register writes
+  for (uint8_t i = 0; i < motors; i++)
+  {
+    rmt_fill_tx_items((rmt_channel_t)i, frames.frame(i).items, dshotFrameItems, 0);
+  }
+  if (pusher)
+  {
+    frames.encode(pusherValue, pusherTelemetry, pusherFrame);
+    rmt_fill_tx_items((rmt_channel_t)motors, pusherFrame.items, dshotFrameItems, 0);
+  }
+  for (uint8_t i = 0; i < motors + (pusher ? 1 : 0); i++)
+  {
+    rmt_tx_start((rmt_channel_t)i, true);
+  }
+}
@@ -0,0 +1,60 @@
+#ifndef MOTORS_H
+#define MOTORS_H
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+#include "DShotRMT.h"
+#include "types.h"
+#include "Esc/analogEsc.h"
+#include "Esc/dshotFrames.h"
+
+// Every flywheel ESC on the board, up to one per RMT channel. update() takes the controller's one
+// throttle, scales it per motor, encodes each distinct DShot value once, loads every channel
+// and then starts them back to back so all frames go out within a couple of microseconds.
+// With dshotMode == DSHOT_OFF the same calls drive AnalogEsc instead.
+//
+// A brushless pusher's ESC, if there is one, takes the RMT channel after the last flywheel and
+// goes out in the same burst. It's DShot only, with its own throttle, and is the only ESC that
+// asks for telemetry so it's the only one answering on the shared telemetry wire.
+
+class MotorArray
+{
+public:
+  // pins as in pins_t::esc, pusherPin 0 for none, returns the number of flywheel motors started
+  uint8_t begin(const int8_t *pins, int8_t pusherPin, dshot_mode_t dshotMode, analogMode_t analogMode,
+                uint32_t updateRate_hz);
+  uint32_t analogRate_hz() const { return analogRate; }
+
+  // share of the flywheel throttle for each motor, e.g. slower first stages in a multi stage blaster
+  void setTargets(const uint8_t *target_pct);
+  // DShot only, bit n reverses motor n, sent as ESC commands by the next few zero throttle updates
+  void setDirections(uint8_t reversedMask);
+
+  // sent with the next update(), 0 is motor stop so an ESC set to brake on stop brakes
+  void setPusher(uint32_t throttle, bool requestTelemetry);
+  bool hasPusher() const { return pusher; }
+
+  void update(uint32_t throttle); // throttle scale is 0 - 1999
+  // stops every channel's signal where it is, ESCs treat no signal as a disarm. For the failsafe,
+  // so it only touches the peripherals and not the state update() works from, the next update() restarts them
+  void stop();
+  uint8_t count() const { return motors; }
+
+private:
+  static const uint8_t directionCommandRepeats = 10; // ESCs only act on commands seen 6 times or more
+
+  uint8_t motors = 0;
+  bool dshot = false;
+  uint32_t analogRate = 0;
+  uint8_t targets_pct[maxMotors];
+  uint8_t reversed = 0;
+  uint8_t directionFrames = 0;
+  bool pusher = false;
+  uint16_t pusherValue = 0;
+  bool pusherTelemetry = false;
+  dshotFrame_t pusherFrame;
+  AnalogEsc analog;
+  DshotFrames frames;
+};
+
+#endif // MOTORS_H
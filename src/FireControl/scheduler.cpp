@@ -0,0 +1,164 @@
+#include <FireControl/scheduler.h>
+
+// how late a stroke may start and still be counted as on its deadline, about a control tick
+static const uint32_t lateSlack_us = 1000;
+
+void FireScheduler::configure(const fireConfig_t &newConfig)
+{
+  config = newConfig;
+  if (config.burstLength == 0)
+  {
+    config.burstLength = 1;
+  }
+  if (config.rampStartRate_dpm == 0)
+  {
+    config.rampStartRate_dpm = config.rateOfFire_dpm; // 0 would mean "unlimited" at the start of the ramp
+  }
+}
+
+void FireScheduler::triggerPressed(uint32_t now_us)
+{
+  bool wasPending = pending();
+  pressTime = now_us;
+  switch (config.mode)
+  {
+  case FIRE_BURST:
+    if (config.releaseMode == RELEASE_CANCEL)
+    {
+      queued = config.burstLength;
+    }
+    else if (config.releaseMode == RELEASE_FINISH_BURST)
+    {
+      if (queued < config.burstLength)
+      {
+        queued += config.burstLength;
+      }
+    }
+    else
+    {
+      queued += config.burstLength;
+    }
+    break;
+
+  case FIRE_AUTO:
+  case FIRE_RAMPING_AUTO:
+    holding = true;
+    break;
+
+  case FIRE_BINARY:
+    queued += 1;
+    break;
+  }
+  if (!wasPending)
+  {
+    startTimeline(now_us);
+  }
+}
+
+void FireScheduler::triggerReleased(uint32_t now_us)
+{
+  bool wasPending = pending();
+  switch (config.mode)
+  {
+  case FIRE_BURST:
+    if (config.releaseMode == RELEASE_CANCEL)
+    {
+      queued = 0;
+    }
+    break;
+
+  case FIRE_AUTO:
+  case FIRE_RAMPING_AUTO:
+    holding = false;
+    break;
+
+  case FIRE_BINARY:
+    queued += 1;
+    break;
+  }
+  if (!wasPending && pending())
+  {
+    startTimeline(now_us);
+  }
+}
+
+void FireScheduler::cancel()
+{
+  queued = 0;
+  holding = false;
+}
+
+fireSchedulerState_t FireScheduler::saveState() const
+{
+  return {queued, holding, hasFired, paced, pressTime, lastShot, nextShot, fired};
+}
+
+void FireScheduler::restoreState(const fireSchedulerState_t &state)
+{
+  queued = state.queued;
+  holding = state.holding;
+  hasFired = state.hasFired;
+  paced = state.paced;
+  pressTime = state.pressTime;
+  lastShot = state.lastShot;
+  nextShot = state.nextShot;
+  fired = state.fired;
+}
+
+void FireScheduler::shotFired(uint32_t now_us)
+{
+  uint32_t period = period_us(now_us);
+  // Anchor to the deadline rather than the actual stroke so a tick of jitter doesn't accumulate.
+  // A stroke later than that, e.g. the first one waiting on spin up or one held up by the pusher,
+  // restarts the timeline from now, anchoring to the old deadline would fire the next shots early
+  // to catch up.
+  if (paced && (uint32_t)(now_us - nextShot) <= lateSlack_us)
+  {
+    lastShot = nextShot;
+  }
+  else
+  {
+    lastShot = now_us;
+  }
+  hasFired = true;
+  paced = true;
+  nextShot = lastShot + period;
+  fired += 1;
+  if (queued > 0)
+  {
+    queued -= 1;
+  }
+}
+
+uint32_t FireScheduler::period_us(uint32_t now_us) const
+{
+  uint32_t rate_dpm = config.rateOfFire_dpm;
+  if (config.mode == FIRE_RAMPING_AUTO && config.rampTime_ms > 0 && config.rampStartRate_dpm < rate_dpm)
+  {
+    uint32_t held_ms = (now_us - pressTime) / 1000;
+    if (held_ms < config.rampTime_ms)
+    {
+      rate_dpm = config.rampStartRate_dpm + (rate_dpm - config.rampStartRate_dpm) * held_ms / config.rampTime_ms;
+    }
+  }
+  if (rate_dpm == 0)
+  {
+    return 0;
+  }
+  return 60000000UL / rate_dpm;
+}
+
+void FireScheduler::startTimeline(uint32_t now_us)
+{
+  // keep the configured spacing from the previous shot even across trigger pulls
+  if (hasFired && (int32_t)(lastShot + period_us(now_us) - now_us) > 0)
+  {
+    nextShot = lastShot + period_us(now_us);
+    paced = true;
+  }
+  else
+  {
+    nextShot = now_us;
+    paced = false;
+  }
+}
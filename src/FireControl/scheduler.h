@@ -0,0 +1,81 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+// Plans shots on a microsecond timeline so the rate of fire is set by configuration
+// instead of by loop rate and pusher timing. Has no hardware dependencies.
+
+enum fireMode_t {
+  FIRE_BURST,        // burstLength shots per trigger pull, burstLength = 1 is semi auto
+  FIRE_AUTO,         // fire at rateOfFire_dpm for as long as the trigger is held
+  FIRE_RAMPING_AUTO, // like FIRE_AUTO, ramping from rampStartRate_dpm up to rateOfFire_dpm over rampTime_ms
+  FIRE_BINARY,       // one shot on pull, one shot on release
+};
+
+enum releaseMode_t {
+  RELEASE_CANCEL,       // stop firing when trigger is released
+  RELEASE_FINISH_BURST, // complete current burst when trigger is released
+  RELEASE_QUEUE,        // fire as many bursts as trigger pulls
+};
+
+typedef struct {
+  fireMode_t mode;
+  releaseMode_t releaseMode; // only used by FIRE_BURST, auto modes always stop on release
+  uint16_t burstLength;
+  uint16_t rateOfFire_dpm;    // darts per minute, 0 = as fast as the pusher can cycle
+  uint16_t rampStartRate_dpm; // FIRE_RAMPING_AUTO only
+  uint16_t rampTime_ms;       // FIRE_RAMPING_AUTO only
+} fireConfig_t;
+
+// what the scheduler carries from one call to the next, so a trace can start mid session
+typedef struct {
+  uint16_t queued;
+  bool holding;
+  bool hasFired;
+  bool paced;
+  uint32_t pressTime;
+  uint32_t lastShot;
+  uint32_t nextShot;
+  uint32_t fired;
+} fireSchedulerState_t;
+
+class FireScheduler
+{
+public:
+  void configure(const fireConfig_t &config);
+
+  void triggerPressed(uint32_t now_us);
+  void triggerReleased(uint32_t now_us);
+  void cancel(); // drop every queued shot, e.g. on pusher stall
+
+  // true while there is at least one shot left to fire
+  bool pending() const { return holding || queued > 0; }
+  // deadline of the next shot, only meaningful while pending()
+  uint32_t nextShot_us() const { return nextShot; }
+  bool shotDue(uint32_t now_us) const { return pending() && (int32_t)(now_us - nextShot) >= 0; }
+  // called by the pusher driver when it commits to a stroke
+  void shotFired(uint32_t now_us);
+
+  uint16_t shotsQueued() const { return queued; }
+  uint32_t shotsFired() const { return fired; }
+
+  fireSchedulerState_t saveState() const;
+  void restoreState(const fireSchedulerState_t &state); // after configure()
+
+private:
+  uint32_t period_us(uint32_t now_us) const;
+  void startTimeline(uint32_t now_us);
+
+  fireConfig_t config = {FIRE_BURST, RELEASE_FINISH_BURST, 1, 0, 0, 0};
+  uint16_t queued = 0;   // finite shots left, used by burst and binary modes
+  bool holding = false;  // auto modes fire until the trigger is released
+  bool hasFired = false; // lastShot is valid
+  bool paced = false;    // nextShot was set by the shot before, not by a trigger pull
+  uint32_t pressTime = 0;
+  uint32_t lastShot = 0;
+  uint32_t nextShot = 0;
+  uint32_t fired = 0;
+};
+
+#endif // SCHEDULER_H
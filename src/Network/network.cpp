@@ -0,0 +1,163 @@
+#include <Network/network.h>
+#include <WiFi.h>
+#include <ArduinoOTA.h>
+
+static const uint32_t stationTimeout_ms = 10000;
+static const uint32_t servicePeriod_ms = 10;
+static const uint32_t taskStack_bytes = 4096;
+
+// copied from the config when starting, the network task never reads the live config
+static char wifiSsid[sizeof(config_t::wifiSsid)];
+static char wifiPass[sizeof(config_t::wifiPass)];
+static char AP_SSID[sizeof(config_t::AP_SSID)];
+static char AP_PW[sizeof(config_t::AP_PW)];
+
+class WiFiBackend : public NetworkBackend
+{
+public:
+  void beginStation() override
+  {
+    WiFi.mode(WIFI_STA);
+    WiFi.begin(wifiSsid, wifiPass);
+  }
+
+  bool stationConnected() override
+  {
+    return WiFi.status() == WL_CONNECTED;
+  }
+
+  void beginAccessPoint() override
+  {
+    Serial.println("WiFi Connection Failed!");
+    WiFi.disconnect();
+    WiFi.mode(WIFI_AP);
+    WiFi.softAP(AP_SSID, AP_PW);
+    Serial.print("Access point ");
+    Serial.print(AP_SSID);
+    Serial.print(" ");
+    Serial.println(WiFi.softAPIP());
+  }
+
+  void beginOta() override
+  {
+    if (WiFi.getMode() == WIFI_STA)
+    {
+      Serial.print("WiFi Connected ");
+      Serial.println(wifiSsid);
+      Serial.println(WiFi.localIP());
+    }
+    ArduinoOTA.setHostname("Dettlaff");
+    // No authentication by default
+    // ArduinoOTA.setPassword("admin");
+    ArduinoOTA
+        .onStart([]()
+                 {
+          String type;
+          if (ArduinoOTA.getCommand() == U_FLASH) {
+            type = "sketch";
+          } else { // U_SPIFFS
+            type = "filesystem";
+          }
+          Serial.println("Start updating " + type); })
+        .onEnd([]()
+               { Serial.println("\nEnd"); })
+        .onProgress([](unsigned int progress, unsigned int total)
+                    { Serial.printf("Progress: %u%%\r", (progress / (total / 100))); })
+        .onError([](ota_error_t error)
+                 {
+          Serial.printf("Error[%u]: ", error);
+          if (error == OTA_AUTH_ERROR) Serial.println("Auth Failed");
+          else if (error == OTA_BEGIN_ERROR) Serial.println("Begin Failed");
+          else if (error == OTA_CONNECT_ERROR) Serial.println("Connect Failed");
+          else if (error == OTA_RECEIVE_ERROR) Serial.println("Receive Failed");
+          else if (error == OTA_END_ERROR) Serial.println("End Failed"); });
+    ArduinoOTA.begin();
+  }
+
+  void handleOta() override
+  {
+    ArduinoOTA.handle();
+  }
+
+  void shutdown() override
+  {
+    ArduinoOTA.end();
+    WiFi.disconnect(true);
+    WiFi.mode(WIFI_OFF); // also deinitializes the WiFi driver and frees its buffers
+    Serial.println("WiFi off");
+  }
+};
+
+static WiFiBackend wifiBackend;
+static NetworkService service(wifiBackend, stationTimeout_ms);
+
+static void networkTaskMain(void *arg)
+{
+  do
+  {
+    service.start(millis());
+    while (service.step(millis()))
+    {
+      vTaskDelay(pdMS_TO_TICKS(servicePeriod_ms));
+    }
+  } while (service.releaseRunner());
+  vTaskDelete(nullptr);
+}
+
+void networkStart()
+{
+  service.requestStart();
+  if (!service.claimRunner())
+  {
+    return; // the running task picks the request up
+  }
+  memcpy(wifiSsid, config->wifiSsid, sizeof(wifiSsid));
+  memcpy(wifiPass, config->wifiPass, sizeof(wifiPass));
+  memcpy(AP_SSID, config->AP_SSID, sizeof(AP_SSID));
+  memcpy(AP_PW, config->AP_PW, sizeof(AP_PW));
+  Serial.println("WiFi starting");
+  // core 0 is where the WiFi stack runs, loop() is on core 1
+  if (xTaskCreatePinnedToCore(networkTaskMain, "network", taskStack_bytes, nullptr, 1, nullptr, 0) != pdPASS)
+  {
+    Serial.println("WiFi task failed to start");
+    service.requestStop();
+    service.releaseRunner();
+  }
+}
+
+void networkStop()
+{
+  service.requestStop();
+}
+
+networkState_t networkState()
+{
+  return service.state();
+}
+
+/**************************************************************/
+/********************* Shell Command Wifi *********************/
+/**************************************************************/
+
+int shellCommandWifi(int argc, char **argv)
+{
+  static const char *const stateNames[] = {"off", "connecting", "station", "access point"};
+
+  if (argc >= 2 && strcmp(argv[1], "start") == 0)
+  {
+    networkStart();
+  }
+  else if (argc >= 2 && strcmp(argv[1], "stop") == 0)
+  {
+    networkStop();
+  }
+  else if (argc >= 2 && strcmp(argv[1], "help") == 0)
+  {
+    shell.println("wifi [start|stop|status]");
+  }
+  else
+  {
+    shell.printf("WiFi is %s\n", stateNames[networkState()]);
+  }
+  return 0;
+}
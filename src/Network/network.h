@@ -0,0 +1,20 @@
+#ifndef NETWORK_H
+#define NETWORK_H
+
+#include <Arduino.h>
+#include "SimpleSerialShell.h"
+#include "Network/networkService.h"
+#include "config.h"
+
+// WiFi and OTA only run while requested, in their own task on the protocol core.
+// While off there is no radio, no WiFi heap and nothing for loop() to service.
+
+extern SimpleSerialShell &shell;
+
+void networkStart();
+void networkStop();
+networkState_t networkState();
+
+int shellCommandWifi(int argc, char **argv);
+
+#endif // NETWORK_H
@@ -0,0 +1,60 @@
+#include <Network/networkService.h>
+
+bool NetworkService::releaseRunner()
+{
+  running.store(false);
+  // a start after the runner saw it wasn't wanted would find a runner and not create one,
+  // so look again, and carry on unless a new runner already claimed it
+  return wanted.load() && claimRunner();
+}
+
+void NetworkService::start(uint32_t now_ms)
+{
+  if (currentState.load() != NET_OFF || !wanted.load())
+  {
+    return;
+  }
+  startTime_ms = now_ms;
+  backend.beginStation();
+  currentState = NET_CONNECTING;
+}
+
+bool NetworkService::step(uint32_t now_ms)
+{
+  networkState_t state = currentState.load();
+  if (state == NET_OFF)
+  {
+    return false;
+  }
+  if (!wanted.load())
+  {
+    backend.shutdown();
+    currentState = NET_OFF;
+    return false;
+  }
+  switch (state)
+  {
+  case NET_CONNECTING:
+    if (backend.stationConnected())
+    {
+      backend.beginOta();
+      currentState = NET_STATION;
+    }
+    else if (now_ms - startTime_ms > stationTimeout_ms)
+    {
+      backend.beginAccessPoint();
+      backend.beginOta();
+      currentState = NET_ACCESS_POINT;
+    }
+    break;
+
+  case NET_STATION:
+  case NET_ACCESS_POINT:
+    backend.handleOta();
+    break;
+
+  default:
+    break;
+  }
+  return true;
+}
@@ -0,0 +1,64 @@
+#ifndef NETWORK_SERVICE_H
+#define NETWORK_SERVICE_H
+
+#include <stdint.h>
+#include <atomic>
+
+// Station-then-softAP bring up and teardown, independent of the radio so it can be
+// driven by a local stand-in backend instead of real WiFi, see tools/networktest.
+//
+// loop() asks for the network on or off from its core, a runner task on the other core
+// calls start() and step() until it's off. Only one runner may exist at a time, whoever
+// gets true from claimRunner() creates it.
+
+class NetworkBackend
+{
+public:
+  virtual ~NetworkBackend() {}
+  virtual void beginStation() = 0; // must not block
+  virtual bool stationConnected() = 0;
+  virtual void beginAccessPoint() = 0;
+  virtual void beginOta() = 0;
+  virtual void handleOta() = 0;
+  virtual void shutdown() = 0; // stop OTA and power the radio down, returning its memory
+};
+
+enum networkState_t {
+  NET_OFF,
+  NET_CONNECTING, // waiting for the station connection
+  NET_STATION,
+  NET_ACCESS_POINT,
+};
+
+class NetworkService
+{
+public:
+  NetworkService(NetworkBackend &backend, uint32_t stationTimeout_ms)
+      : backend(backend), stationTimeout_ms(stationTimeout_ms) {}
+
+  // any core, the last request wins even if the runner hasn't got to the one before yet
+  void requestStart() { wanted.store(true); }
+  void requestStop() { wanted.store(false); }
+  networkState_t state() const { return currentState.load(); }
+
+  // true if there was no runner, the caller must then start one
+  bool claimRunner() { return !running.exchange(true); }
+  // runner only, once step() returned false. True if a start came in meanwhile and the
+  // runner should go round again instead of exiting.
+  bool releaseRunner();
+
+  // runner only, brings the network up if it's still wanted
+  void start(uint32_t now_ms);
+  // runner only, one step of the bring up / service / teardown sequence, returns false once off
+  bool step(uint32_t now_ms);
+
+private:
+  NetworkBackend &backend;
+  uint32_t stationTimeout_ms;
+  uint32_t startTime_ms = 0; // runner only
+  std::atomic<networkState_t> currentState{NET_OFF};
+  std::atomic<bool> wanted{false};
+  std::atomic<bool> running{false};
+};
+
+#endif // NETWORK_SERVICE_H
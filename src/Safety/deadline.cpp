@@ -0,0 +1,151 @@
+#include <Safety/deadline.h>
+#include <esp_task_wdt.h>
+#include <esp_timer.h>
+
+static const uint32_t monitorPeriod_us = 1000;
+
+// per stage budgets, a stage that takes longer counts as a missed deadline
+static const uint16_t stageBudget_us[STAGE_COUNT] = {
+    100, // STAGE_INPUTS
+    100, // STAGE_FIRE_CONTROL
+    300, // STAGE_OUTPUT
+    500, // STAGE_SERVICE
+};
+
+static const char *const stageNames[STAGE_COUNT] = {
+    "inputs",
+    "fire control",
+    "output",
+    "service",
+};
+
+static esp_timer_handle_t monitorTimer = nullptr;
+static void (*failsafeHandler)() = nullptr;
+static uint32_t failsafeTimeout = 0;
+static volatile uint32_t heartbeat_us = 0;
+static volatile bool tripped = false;
+static volatile bool paused = false;
+static uint32_t stageStart_us = 0;
+
+static uint32_t stageMisses[STAGE_COUNT];
+static uint16_t stageMax_us[STAGE_COUNT];
+static uint32_t overruns = 0;
+static uint32_t maxLoopTime_us = 0;
+static volatile uint32_t failsafeTrips = 0;
+
+static void checkHeartbeat(void *arg)
+{
+  if (!tripped && !paused && (uint32_t)(esp_timer_get_time() - heartbeat_us) > failsafeTimeout)
+  {
+    tripped = true;
+    failsafeTrips++;
+    // the outputs stay stopped until loop() comes back and takes them over again
+    failsafeHandler();
+  }
+}
+
+void deadlineBegin(uint32_t failsafeTimeout_us, void (*failsafe)())
+{
+  failsafeTimeout = failsafeTimeout_us;
+  failsafeHandler = failsafe;
+  heartbeat_us = esp_timer_get_time();
+  stageStart_us = heartbeat_us;
+
+  // the task watchdog resets the chip if loop() stops feeding it entirely
+  esp_task_wdt_add(nullptr);
+
+  const esp_timer_create_args_t monitorTimerArgs = {
+      .callback = checkHeartbeat,
+      .arg = nullptr,
+      .dispatch_method = ESP_TIMER_TASK,
+      .name = "deadline",
+  };
+  esp_timer_create(&monitorTimerArgs, &monitorTimer);
+  esp_timer_start_periodic(monitorTimer, monitorPeriod_us);
+}
+
+bool deadlineTickStart(uint32_t now_us)
+{
+  esp_task_wdt_reset();
+  heartbeat_us = now_us;
+  stageStart_us = now_us;
+  if (tripped)
+  {
+    tripped = false;
+    return true;
+  }
+  return false;
+}
+
+void deadlineKeepAlive(uint32_t now_us)
+{
+  esp_task_wdt_reset();
+  heartbeat_us = now_us;
+}
+
+void deadlinePause()
+{
+  esp_task_wdt_reset();
+  paused = true;
+}
+
+void deadlineResume(uint32_t now_us)
+{
+  deadlineKeepAlive(now_us);
+  paused = false;
+}
+
+void deadlineStageStart(uint32_t now_us)
+{
+  stageStart_us = now_us;
+}
+
+void deadlineStageEnd(controlStage_t stage, uint32_t now_us)
+{
+  uint32_t stageTime_us = now_us - stageStart_us;
+  stageStart_us = now_us;
+  if (stageTime_us > stageBudget_us[stage])
+  {
+    stageMisses[stage]++;
+  }
+  if (stageTime_us > stageMax_us[stage])
+  {
+    stageMax_us[stage] = min(stageTime_us, (uint32_t)UINT16_MAX);
+  }
+}
+
+void deadlineTickEnd(uint32_t loopTime_us, uint32_t targetLoopTime_us)
+{
+  if (loopTime_us > targetLoopTime_us)
+  {
+    overruns++;
+  }
+  if (loopTime_us > maxLoopTime_us)
+  {
+    maxLoopTime_us = loopTime_us;
+  }
+}
+
+/**************************************************************/
+/******************** Shell Command Faults ********************/
+/**************************************************************/
+
+int shellCommandFaults(int argc, char **argv)
+{
+  if (argc >= 2 && strcmp(argv[1], "clear") == 0)
+  {
+    memset(stageMisses, 0, sizeof(stageMisses));
+    memset(stageMax_us, 0, sizeof(stageMax_us));
+    overruns = 0;
+    maxLoopTime_us = 0;
+    failsafeTrips = 0;
+    return 0;
+  }
+  shell.printf("failsafe trips  %u\n", failsafeTrips);
+  shell.printf("loop overruns   %u (max %u us)\n", overruns, maxLoopTime_us);
+  for (uint8_t i = 0; i < STAGE_COUNT; i++)
+  {
+    shell.printf("%-15s %u missed (budget %u us, max %u us)\n", stageNames[i], stageMisses[i], stageBudget_us[i], stageMax_us[i]);
+  }
+  return 0;
+}
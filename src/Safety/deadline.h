@@ -0,0 +1,37 @@
+#ifndef DEADLINE_H
+#define DEADLINE_H
+
+#include <Arduino.h>
+#include "SimpleSerialShell.h"
+
+// Control deadline monitoring. loop() is the only thing that feeds the task watchdog, and an
+// independent esp_timer checks the tick heartbeat and calls the failsafe if loop() stops
+// ticking for longer than the failsafe timeout, whatever loop() happens to be stuck on.
+
+enum controlStage_t {
+  STAGE_INPUTS,       // switches and buttons
+  STAGE_FIRE_CONTROL, // flywheel and pusher state machine
+  STAGE_OUTPUT,       // throttle computation and ESC output
+  STAGE_SERVICE,      // shell and anything else done after the tick's wait
+  STAGE_COUNT,
+};
+
+extern SimpleSerialShell &shell;
+
+// failsafe is called once per trip from the esp_timer task, keep it to GPIO writes and stopping
+// ESC output, it mustn't share any state with loop()
+void deadlineBegin(uint32_t failsafeTimeout_us, void (*failsafe)());
+// returns true if the failsafe tripped since the last tick, loop() must reset its state
+bool deadlineTickStart(uint32_t now_us);
+// feeds the watchdogs from inside long running work that is known to be safe, like the bench
+void deadlineKeepAlive(uint32_t now_us);
+// for a single blocking call that can't feed the heartbeat, like a flash write, only while the blaster is idle
+void deadlinePause();
+void deadlineResume(uint32_t now_us);
+void deadlineStageStart(uint32_t now_us); // only needed after time that isn't part of any stage, like the tick's wait
+void deadlineStageEnd(controlStage_t stage, uint32_t now_us);
+void deadlineTickEnd(uint32_t loopTime_us, uint32_t targetLoopTime_us);
+
+int shellCommandFaults(int argc, char **argv);
+
+#endif // DEADLINE_H
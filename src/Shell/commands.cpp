@@ -0,0 +1,93 @@
+#include <Shell/commands.h>
+
+static const shellCommand_t *commandTable = nullptr;
+static uint8_t commandCount = 0;
+static NameIndex<shellCommand_t, 32> commandIndex;
+
+static char line[commandLineLength];
+static uint8_t lineLength = 0;
+static bool overflowed = false; // drop the rest of a line that didn't fit
+
+bool commandsBegin(const shellCommand_t *commands, uint8_t count)
+{
+  commandTable = commands;
+  commandCount = count;
+  return commandIndex.build(commands, count);
+}
+
+static void help()
+{
+  for (uint8_t i = 0; i < commandCount; i++)
+  {
+    shell.printf("%-10s %s\n", commandTable[i].name, commandTable[i].help);
+  }
+}
+
+static void execute()
+{
+  char *argv[commandMaxArgs];
+  int argc = 0;
+  char *save;
+  for (char *token = strtok_r(line, " \t", &save); token != nullptr && argc < commandMaxArgs; token = strtok_r(nullptr, " \t", &save))
+  {
+    argv[argc++] = token;
+  }
+  if (argc == 0)
+  {
+    return;
+  }
+  if (strcmp(argv[0], "help") == 0 || strcmp(argv[0], "?") == 0)
+  {
+    help();
+    return;
+  }
+  const shellCommand_t *command = commandIndex.find(argv[0]);
+  if (command == nullptr)
+  {
+    shell.printf("Unknown command %s, try help\n", argv[0]);
+    return;
+  }
+  command->run(argc, argv);
+}
+
+void commandsService(Stream &in)
+{
+  for (uint8_t budget = commandInputBudget; budget > 0 && in.available() > 0; budget--)
+  {
+    int c = in.read();
+    if (c == '\r' || c == '\n')
+    {
+      bool complete = lineLength > 0 || overflowed;
+      line[lineLength] = '\0';
+      if (overflowed)
+      {
+        shell.println("Line too long, ignored");
+      }
+      else if (lineLength > 0)
+      {
+        execute();
+      }
+      lineLength = 0;
+      overflowed = false;
+      if (complete)
+      {
+        return; // one command per tick, the rest of the input waits for the next one
+      }
+    }
+    else if (c == '\b' || c == 0x7f)
+    {
+      if (lineLength > 0 && !overflowed)
+      {
+        lineLength--;
+      }
+    }
+    else if (lineLength < commandLineLength - 1)
+    {
+      line[lineLength++] = c;
+    }
+    else
+    {
+      overflowed = true;
+    }
+  }
+}
@@ -0,0 +1,32 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <Arduino.h>
+#include "SimpleSerialShell.h"
+#include "Shell/nameIndex.h"
+
+// Shell input handling. main.cpp owns a const table of commands; commandsService() is called
+// once per tick and reads at most commandInputBudget bytes into a fixed line buffer, so an
+// attached terminal costs a small bounded amount per tick whatever is typed into it. A complete
+// line is split in place and dispatched through a NameIndex, at most one command per tick.
+// Output still goes through shell, which stays attached to Serial.
+
+static const uint8_t commandInputBudget = 16; // bytes per tick, more than 115200 baud delivers per ms
+static const uint8_t commandLineLength = 96;
+static const uint8_t commandMaxArgs = 8;
+
+typedef struct {
+  const char *name;
+  uint32_t hash;
+  int (*run)(int argc, char **argv);
+  const char *help;
+} shellCommand_t;
+
+#define SHELL_COMMAND(name, run, help) {name, nameHash(name), run, help}
+
+extern SimpleSerialShell &shell;
+
+bool commandsBegin(const shellCommand_t *commands, uint8_t count); // false if the table has duplicates
+void commandsService(Stream &in);
+
+#endif // COMMANDS_H
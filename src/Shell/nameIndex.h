@@ -0,0 +1,72 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <stdint.h>
+#include <string.h>
+
+// Constant time name lookup for the shell's fixed tables. Each table entry carries the hash of
+// its name, computed by the compiler, and the index is a small open addressing array of table
+// positions filled in once at startup, so a lookup is one hash of the typed name plus usually
+// one strcmp, with no heap and no walking the table.
+
+// FNV-1a
+constexpr uint32_t nameHash(const char *name, uint32_t hash = 2166136261u)
+{
+  return *name ? nameHash(name + 1, (hash ^ (uint8_t)*name) * 16777619u) : hash;
+}
+
+// Entry needs .name and .hash, Slots must be a power of two and larger than the table
+template <typename Entry, uint16_t Slots>
+class NameIndex
+{
+public:
+  static const uint8_t empty = 0xff;
+
+  NameIndex() { memset(slots, empty, sizeof(slots)); }
+
+  // returns false if the table doesn't fit or has a duplicate name
+  bool build(const Entry *entries, uint8_t count)
+  {
+    static_assert((Slots & (Slots - 1)) == 0, "Slots must be a power of two");
+    table = entries;
+    memset(slots, empty, sizeof(slots));
+    if (count >= Slots || count >= empty)
+    {
+      return false;
+    }
+    for (uint8_t i = 0; i < count; i++)
+    {
+      if (find(entries[i].name) != nullptr)
+      {
+        return false;
+      }
+      uint16_t slot = entries[i].hash & (Slots - 1);
+      while (slots[slot] != empty)
+      {
+        slot = (slot + 1) & (Slots - 1);
+      }
+      slots[slot] = i;
+    }
+    return true;
+  }
+
+  const Entry *find(const char *name) const
+  {
+    uint32_t hash = nameHash(name);
+    for (uint16_t slot = hash & (Slots - 1); slots[slot] != empty; slot = (slot + 1) & (Slots - 1))
+    {
+      const Entry &entry = table[slots[slot]];
+      if (entry.hash == hash && strcmp(entry.name, name) == 0)
+      {
+        return &entry;
+      }
+    }
+    return nullptr;
+  }
+
+private:
+  const Entry *table = nullptr;
+  uint8_t slots[Slots];
+};
+
+#endif // NAME_INDEX_H
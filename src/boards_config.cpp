@@ -7,10 +7,7 @@ const pins_t pins_v0_4_n20 = {
   .flywheel = 2,
   .pusher = 12,
   .pusherBrake = 13,
-  .esc1 = 19,
-  .esc2 = 18,
-  .esc3 = 5,
-  .esc4 = 17,
+  .esc = {19, 18, 5, 17},
   .telem = 16,
   .button = 0,
   .batteryADC = 35,
@@ -20,10 +17,21 @@ const pins_t pins_v0_4_noid = {
   .revSwitch = 15,
   .triggerSwitch = 32,
   .pusher = 2,
-  .esc1 = 19,
-  .esc2 = 18,
-  .esc3 = 5,
-  .esc4 = 17,
+  .esc = {19, 18, 5, 17},
+  .telem = 16,
+  .button = 0,
+  .batteryADC = 35,
+};
+
+// v0.4 with a brushless pusher, its ESC's signal wire on the N20 driver's brake pin instead of
+// the driver, and its telemetry wire on telem
+const pins_t pins_v0_4_brushless = {
+  .revSwitch = 15,
+  .triggerSwitch = 32,
+  .cycleSwitch = 23,
+  .flywheel = 2,
+  .esc = {19, 18, 5, 17},
+  .pusherEsc = 13,
   .telem = 16,
   .button = 0,
   .batteryADC = 35,
@@ -36,10 +44,7 @@ const pins_t pins_v0_3_n20 = {
   .flywheel = 2,
   .pusher = 12,
   .pusherBrake = 13,
-  .esc1 = 19,
-  .esc2 = 18,
-  .esc3 = 5,
-  .esc4 = 17,
+  .esc = {19, 18, 5, 17},
   .telem = 16,
   .button = 0,
   .batteryADC = 33,
@@ -49,10 +54,7 @@ const pins_t pins_v0_3_noid = {
   .revSwitch = 15,
   .triggerSwitch = 32,
   .pusher = 2,
-  .esc1 = 19,
-  .esc2 = 18,
-  .esc3 = 5,
-  .esc4 = 17,
+  .esc = {19, 18, 5, 17},
   .telem = 16,
   .button = 0,
   .batteryADC = 33,
@@ -60,10 +62,7 @@ const pins_t pins_v0_3_noid = {
 
 const pins_t pins_v0_2 = {
   .revSwitch = 15,
-  .esc1 = 19,
-  .esc2 = 18,
-  .esc3 = 5,
-  .esc4 = 17,
+  .esc = {19, 18, 5, 17},
   .telem = 16,
   .button = 0,
   .batteryADC = 12,
@@ -71,8 +70,5 @@ const pins_t pins_v0_2 = {
 
 const pins_t pins_v0_1 = {
   .revSwitch = 12,
-  .esc1 = 4,
-  .esc2 = 2,
-  .esc3 = 15,
-  .esc4 = 13,
+  .esc = {4, 2, 15, 13},
 };
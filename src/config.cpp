@@ -0,0 +1,380 @@
+#include <config.h>
+#include <Preferences.h>
+#include <atomic>
+#include "Shell/nameIndex.h"
+#include "Safety/deadline.h"
+
+static const char *const nvsNamespace = "dettlaff";
+static const char *const nvsKey = "config";
+
+static config_t buffers[2];
+static uint8_t writeIndex = 1;                                // buffer the next publish goes into, owned by the publisher
+static std::atomic<const config_t *> pendingConfig(nullptr); // published but not yet picked up by loop()
+static config_t editing;                                      // staged by the shell until applied
+static bool (*configIdle)() = nullptr;
+
+static void buildParamIndex(); // the parameter table is with the shell command below
+
+const config_t *config = &defaultConfig;
+
+void configLoad()
+{
+  buffers[0] = defaultConfig;
+  Preferences prefs;
+  if (prefs.begin(nvsNamespace, true))
+  {
+    config_t stored;
+    if (prefs.getBytesLength(nvsKey) == sizeof(stored) && prefs.getBytes(nvsKey, &stored, sizeof(stored)) == sizeof(stored) &&
+        stored.version == configVersion && configValidate(stored))
+    {
+      buffers[0] = stored;
+    }
+    prefs.end();
+  }
+  config = &buffers[0];
+  writeIndex = 1;
+  editing = buffers[0];
+  buildParamIndex();
+}
+
+void configSetIdleCheck(bool (*idle)())
+{
+  configIdle = idle;
+}
+
+static bool terminated(const char *str, size_t size)
+{
+  return memchr(str, '\0', size) != nullptr;
+}
+
+static bool percentages(const uint8_t *values, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    if (values[i] > 100)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool configValidate(const config_t &candidate)
+{
+  return candidate.version == configVersion &&
+         candidate.pusherType <= PUSHER_BRUSHLESS &&
+         candidate.fireMode <= FIRE_BINARY &&
+         candidate.releaseMode <= RELEASE_QUEUE &&
+         candidate.burstLength > 0 &&
+         candidate.idleRPM <= candidate.revRPM &&
+         (candidate.idleRPMMax == 0 || (candidate.idleRPM <= candidate.idleRPMMax && candidate.idleRPMMax <= candidate.revRPM)) &&
+         candidate.idleTimeMin_ms <= candidate.idleTime_ms &&
+         candidate.motorKv > 0 &&
+         candidate.solenoidExtendTime_ms > 0 &&
+         candidate.pusherStallTime_ms > 0 &&
+         candidate.spindownSpeed > 0 &&
+         (candidate.pusherType != PUSHER_BRUSHLESS || (candidate.dshotMode != DSHOT_OFF && candidate.pusherThrottle > 0)) &&
+         candidate.dshotMode <= DSHOT1200 &&
+         candidate.analogMode <= ANALOG_MULTISHOT &&
+         percentages(candidate.motorTarget_pct, maxMotors) &&
+         candidate.targetLoopTime_us >= 100 && candidate.targetLoopTime_us <= 20000 &&
+         candidate.failsafeTimeout_ms >= 2 && candidate.failsafeTimeout_ms * 1000UL > candidate.targetLoopTime_us &&
+         terminated(candidate.wifiSsid, sizeof(candidate.wifiSsid)) &&
+         terminated(candidate.wifiPass, sizeof(candidate.wifiPass)) &&
+         terminated(candidate.AP_SSID, sizeof(candidate.AP_SSID)) &&
+         terminated(candidate.AP_PW, sizeof(candidate.AP_PW));
+}
+
+bool configPublish(const config_t &next)
+{
+  // validation happens here so loop() never pays for it
+  if (!configValidate(next) || pendingConfig.load() != nullptr)
+  {
+    return false;
+  }
+  // loop() let go of this buffer when it picked up the previous publish
+  buffers[writeIndex] = next;
+  pendingConfig.store(&buffers[writeIndex]);
+  writeIndex ^= 1;
+  return true;
+}
+
+bool configApplyPending()
+{
+  const config_t *next = pendingConfig.exchange(nullptr);
+  if (next == nullptr)
+  {
+    return false;
+  }
+  config = next;
+  return true;
+}
+
+bool configSave(const config_t &toSave)
+{
+  if (!configValidate(toSave))
+  {
+    return false;
+  }
+  Preferences prefs;
+  if (!prefs.begin(nvsNamespace, false))
+  {
+    return false;
+  }
+  bool saved = prefs.putBytes(nvsKey, &toSave, sizeof(toSave)) == sizeof(toSave);
+  prefs.end();
+  return saved;
+}
+
+/**************************************************************/
+/******************** Shell Command Config ********************/
+/**************************************************************/
+
+enum paramType_t {
+  PARAM_UINT, // any unsigned integer or enum, sized by the field
+  PARAM_BOOL,
+  PARAM_STRING,
+};
+
+typedef struct {
+  const char *name;
+  uint32_t hash;
+  paramType_t type;
+  size_t offset;
+  size_t size;
+  uint32_t min; // PARAM_UINT only
+  uint32_t max;
+  const char *unit;
+} configParam_t;
+
+#define CONFIG_PARAM(field, type, min, max, unit) \
+  {#field, nameHash(#field), type, offsetof(config_t, field), sizeof(((config_t *)nullptr)->field), min, max, unit}
+#define CONFIG_BOOL(field) CONFIG_PARAM(field, PARAM_BOOL, 0, 1, "")
+#define CONFIG_STRING(field) CONFIG_PARAM(field, PARAM_STRING, 0, 0, "")
+
+static const configParam_t params[] = {
+    CONFIG_PARAM(revRPM, PARAM_UINT, 0, 100000, "rpm"),
+    CONFIG_PARAM(idleRPM, PARAM_UINT, 0, 100000, "rpm"),
+    CONFIG_PARAM(idleTime_ms, PARAM_UINT, 0, 600000, "ms"),
+    CONFIG_PARAM(idleRPMMax, PARAM_UINT, 0, 100000, "rpm"),
+    CONFIG_PARAM(idleTimeMin_ms, PARAM_UINT, 0, 600000, "ms"),
+    CONFIG_PARAM(idleActiveGap_ms, PARAM_UINT, 0, 600000, "ms"),
+    CONFIG_PARAM(idleLowBattery_mv, PARAM_UINT, 0, 3300, "mV"),
+    CONFIG_PARAM(motorKv, PARAM_UINT, 1, 10000, "rpm/V"),
+    CONFIG_PARAM(pusherType, PARAM_UINT, 0, PUSHER_BRUSHLESS, "pusherType_t"),
+    CONFIG_PARAM(fireMode, PARAM_UINT, 0, FIRE_BINARY, "fireMode_t"),
+    CONFIG_PARAM(burstLength, PARAM_UINT, 1, 100, "darts"),
+    CONFIG_PARAM(releaseMode, PARAM_UINT, 0, RELEASE_QUEUE, "releaseMode_t"),
+    CONFIG_PARAM(rateOfFire_dpm, PARAM_UINT, 0, 3000, "darts/min"),
+    CONFIG_PARAM(rampStartRate_dpm, PARAM_UINT, 0, 3000, "darts/min"),
+    CONFIG_PARAM(rampTime_ms, PARAM_UINT, 0, 10000, "ms"),
+    CONFIG_PARAM(firingDelay_ms, PARAM_UINT, 0, 2000, "ms"),
+    CONFIG_PARAM(solenoidExtendTime_ms, PARAM_UINT, 1, 1000, "ms"),
+    CONFIG_PARAM(solenoidRetractTime_ms, PARAM_UINT, 0, 1000, "ms"),
+    CONFIG_PARAM(pusherStallTime_ms, PARAM_UINT, 1, 5000, "ms"),
+    CONFIG_PARAM(spindownSpeed, PARAM_UINT, 1, 1999, "throttle/tick"),
+    CONFIG_PARAM(pusherThrottle, PARAM_UINT, 0, 1999, "throttle"),
+    CONFIG_PARAM(pusherStrokeERevs, PARAM_UINT, 0, 1000, "erev"),
+    CONFIG_PARAM(pusherBrakeTime_ms, PARAM_UINT, 0, 500, "ms"),
+    CONFIG_BOOL(revSwitchNormallyClosed),
+    CONFIG_BOOL(triggerSwitchNormallyClosed),
+    CONFIG_BOOL(cycleSwitchNormallyClosed),
+    CONFIG_PARAM(debounceTime, PARAM_UINT, 0, 200, "ms"),
+    CONFIG_PARAM(wifiButtonHoldTime_ms, PARAM_UINT, 100, 10000, "ms"),
+    CONFIG_STRING(wifiSsid),
+    CONFIG_STRING(wifiPass),
+    CONFIG_STRING(AP_SSID),
+    CONFIG_STRING(AP_PW),
+    CONFIG_PARAM(dshotMode, PARAM_UINT, 0, DSHOT1200, "dshot_mode_t"),
+    CONFIG_PARAM(analogMode, PARAM_UINT, 0, ANALOG_MULTISHOT, "analogMode_t"),
+    CONFIG_PARAM(motorTarget_pct[0], PARAM_UINT, 0, 100, "%"),
+    CONFIG_PARAM(motorTarget_pct[1], PARAM_UINT, 0, 100, "%"),
+    CONFIG_PARAM(motorTarget_pct[2], PARAM_UINT, 0, 100, "%"),
+    CONFIG_PARAM(motorTarget_pct[3], PARAM_UINT, 0, 100, "%"),
+    CONFIG_PARAM(motorTarget_pct[4], PARAM_UINT, 0, 100, "%"),
+    CONFIG_PARAM(motorTarget_pct[5], PARAM_UINT, 0, 100, "%"),
+    CONFIG_PARAM(motorTarget_pct[6], PARAM_UINT, 0, 100, "%"),
+    CONFIG_PARAM(motorTarget_pct[7], PARAM_UINT, 0, 100, "%"),
+    CONFIG_PARAM(motorReversed, PARAM_UINT, 0, 0xff, "bitmask"),
+    CONFIG_PARAM(targetLoopTime_us, PARAM_UINT, 100, 20000, "us"),
+    CONFIG_PARAM(escArmTime_ms, PARAM_UINT, 0, 5000, "ms"),
+    CONFIG_PARAM(bootTargetArmed_ms, PARAM_UINT, 0, 10000, "ms"),
+    CONFIG_PARAM(failsafeTimeout_ms, PARAM_UINT, 2, 1000, "ms"),
+};
+
+static NameIndex<configParam_t, 64> paramIndex;
+
+static void buildParamIndex()
+{
+  paramIndex.build(params, sizeof(params) / sizeof(params[0]));
+}
+
+static const configParam_t *findParam(const char *name)
+{
+  return paramIndex.find(name);
+}
+
+static uint32_t readUint(const uint8_t *field, size_t size)
+{
+  if (size == 1)
+  {
+    return *field;
+  }
+  else if (size == 2)
+  {
+    uint16_t value;
+    memcpy(&value, field, sizeof(value));
+    return value;
+  }
+  uint32_t value;
+  memcpy(&value, field, sizeof(value));
+  return value;
+}
+
+static void writeUint(uint8_t *field, size_t size, uint32_t value)
+{
+  if (size == 1)
+  {
+    *field = value;
+  }
+  else if (size == 2)
+  {
+    uint16_t narrowed = value;
+    memcpy(field, &narrowed, sizeof(narrowed));
+  }
+  else
+  {
+    memcpy(field, &value, sizeof(value));
+  }
+}
+
+static void printParam(const configParam_t &param, const config_t &from, bool withRange = false)
+{
+  const uint8_t *field = (const uint8_t *)&from + param.offset;
+  switch (param.type)
+  {
+  case PARAM_UINT:
+    if (withRange)
+    {
+      shell.printf("%s = %u %s [%u - %u]\n", param.name, readUint(field, param.size), param.unit, param.min, param.max);
+    }
+    else
+    {
+      shell.printf("%s = %u %s\n", param.name, readUint(field, param.size), param.unit);
+    }
+    break;
+  case PARAM_BOOL:
+    shell.printf("%s = %s\n", param.name, *(const bool *)field ? "true" : "false");
+    break;
+  case PARAM_STRING:
+    shell.printf("%s = %s\n", param.name, (const char *)field);
+    break;
+  }
+}
+
+static bool setParam(const configParam_t &param, config_t &to, const char *value)
+{
+  uint8_t *field = (uint8_t *)&to + param.offset;
+  switch (param.type)
+  {
+  case PARAM_UINT:
+  {
+    char *end;
+    unsigned long parsed = strtoul(value, &end, 0);
+    if (end == value || *end != '\0' || parsed < param.min || parsed > param.max)
+    {
+      return false;
+    }
+    writeUint(field, param.size, parsed);
+    return true;
+  }
+  case PARAM_BOOL:
+    if (strcmp(value, "true") == 0 || strcmp(value, "1") == 0)
+    {
+      *(bool *)field = true;
+    }
+    else if (strcmp(value, "false") == 0 || strcmp(value, "0") == 0)
+    {
+      *(bool *)field = false;
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  case PARAM_STRING:
+    if (strlen(value) >= param.size)
+    {
+      return false;
+    }
+    strcpy((char *)field, value);
+    return true;
+  }
+  return false;
+}
+
+int shellCommandConfig(int argc, char **argv)
+{
+  const char *function = argc >= 2 ? argv[1] : "list";
+
+  if (strcmp(function, "list") == 0)
+  {
+    for (const configParam_t &param : params)
+    {
+      printParam(param, editing);
+    }
+  }
+  else if (strcmp(function, "get") == 0 && argc >= 3)
+  {
+    const configParam_t *param = findParam(argv[2]);
+    if (param == nullptr)
+    {
+      shell.printf("Unknown setting %s\n", argv[2]);
+      return -1;
+    }
+    printParam(*param, editing, true);
+  }
+  else if (strcmp(function, "set") == 0 && argc >= 4)
+  {
+    const configParam_t *param = findParam(argv[2]);
+    if (param == nullptr || !setParam(*param, editing, argv[3]))
+    {
+      shell.printf("Can't set %s to %s\n", argv[2], argv[3]);
+      return -1;
+    }
+    printParam(*param, editing);
+  }
+  else if (strcmp(function, "apply") == 0 || strcmp(function, "save") == 0)
+  {
+    bool save = strcmp(function, "save") == 0;
+    // the flash write holds up loop() for tens of ms
+    if (save && (configIdle == nullptr || !configIdle()))
+    {
+      shell.println("Motors must be stopped and the pusher idle to save the config, use config apply for now");
+      return -1;
+    }
+    if (!configPublish(editing))
+    {
+      shell.println("Config invalid or previous change still pending, not applied");
+      return -1;
+    }
+    shell.println("Config applied, takes effect once the pusher is idle");
+    if (save)
+    {
+      deadlinePause();
+      bool saved = configSave(editing);
+      deadlineResume(micros());
+      shell.println(saved ? "Config saved" : "Config save failed");
+    }
+  }
+  else if (strcmp(function, "defaults") == 0)
+  {
+    editing = defaultConfig;
+    shell.println("Defaults staged, use config apply or config save");
+  }
+  else
+  {
+    shell.println("config [list|get <name>|set <name> <value>|apply|save|defaults]");
+  }
+  return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <Arduino.h>
+#include "DShotRMT.h"
+#include "SimpleSerialShell.h"
+#include "types.h"
+#include "FireControl/scheduler.h"
+#include "Esc/analogEsc.h"
+
+// Every runtime tunable lives in one versioned struct, stored in NVS and published to
+// loop() by swapping between two buffers at a tick boundary. loop() only ever reads
+// through the config pointer, and only configApplyPending() changes it.
+
+// bump whenever config_t changes, stored configs with another version are ignored
+static const uint16_t configVersion = 5;
+
+typedef struct {
+  uint16_t version;
+  uint32_t revRPM;
+  uint32_t idleRPM;
+  uint32_t idleTime_ms; // how long to idle the flywheels for, the longest hold with the idle governor
+  uint32_t idleRPMMax;  // 0 = always idle at idleRPM, otherwise the idle governor picks between the two
+  uint32_t idleTimeMin_ms;
+  uint32_t idleActiveGap_ms;
+  uint32_t idleLowBattery_mv; // at the ADC, 0 = ignore the battery
+  uint32_t motorKv;
+  pusherType_t pusherType;
+  fireMode_t fireMode;
+  uint16_t burstLength;
+  releaseMode_t releaseMode;
+  uint16_t rateOfFire_dpm; // darts per minute, 0 = as fast as the pusher can cycle
+  uint16_t rampStartRate_dpm;
+  uint16_t rampTime_ms;
+  uint16_t firingDelay_ms; // delay to allow flywheels to spin up before pushing dart
+  uint16_t solenoidExtendTime_ms;
+  uint16_t solenoidRetractTime_ms;
+  uint16_t pusherStallTime_ms;
+  uint16_t spindownSpeed;
+  uint16_t pusherThrottle;     // PUSHER_BRUSHLESS, 0 - 1999
+  uint16_t pusherStrokeERevs;  // PUSHER_BRUSHLESS, 0 = no position estimate, brake on the cycle switch
+  uint16_t pusherBrakeTime_ms; // PUSHER_BRUSHLESS
+  bool revSwitchNormallyClosed;     // takes effect after reboot
+  bool triggerSwitchNormallyClosed; // takes effect after reboot
+  bool cycleSwitchNormallyClosed;   // takes effect after reboot
+  uint16_t debounceTime;            // ms, takes effect after reboot
+  uint16_t wifiButtonHoldTime_ms;
+  char wifiSsid[32];
+  char wifiPass[63];
+  char AP_SSID[32];
+  char AP_PW[32];
+  dshot_mode_t dshotMode;  // takes effect after reboot
+  analogMode_t analogMode; // takes effect after reboot
+  uint8_t motorTarget_pct[maxMotors]; // share of the flywheel throttle per motor, in pins_t::esc order
+  uint8_t motorReversed;              // bit n reverses motor n, DShot only, takes effect after reboot
+  uint16_t targetLoopTime_us;
+  uint16_t escArmTime_ms;
+  uint16_t bootTargetArmed_ms;
+  uint16_t failsafeTimeout_ms; // takes effect after reboot
+} config_t;
+
+extern SimpleSerialShell &shell;
+
+extern const config_t defaultConfig; // from main.cpp
+extern const config_t *config;       // the config loop() is running with
+
+void configLoad();                         // call once at the start of setup()
+bool configValidate(const config_t &candidate);
+bool configPublish(const config_t &next);  // returns false if invalid or the last publish hasn't been applied yet
+bool configApplyPending();                 // only called by loop() at the start of a tick
+bool configSave(const config_t &toSave);
+// config save blocks on flash, so it's only allowed while this says the blaster is idle
+void configSetIdleCheck(bool (*idle)());
+
+int shellCommandConfig(int argc, char **argv);
+
+#endif // CONFIG_H
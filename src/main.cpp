@@ -1,160 +1,323 @@
 #include <Arduino.h>
-#include <ArduinoOTA.h>
+#include <esp_timer.h>
+#include <atomic>
 #define BOUNCE_LOCK_OUT // improves rev responsiveness at the risk of spurious signals from noise
 #include "Bounce2.h"
-#include "DShotRMT.h"
-#include "ESP32Servo.h"
 #include "types.h"
+#include "config.h"
 #include "boards_config.cpp"
 
 #include <SimpleSerialShell.h>
 
 #include "Pushers/solenoid.h"
+#include "Control/controller.h"
+#include "Control/snapshot.h"
+#include "Control/latency.h"
+#include "Esc/motors.h"
+#include "Esc/escTelemetry.h"
+#include "Diagnostics/boot.h"
+#include "Diagnostics/bench.h"
+#include "Diagnostics/trace.h"
+#include "Diagnostics/status.h"
+#include "Network/network.h"
+#include "Safety/deadline.h"
+#include "Shell/commands.h"
 
 // Configuration Variables
+// These are the defaults, settings saved with "config save" over the shell take priority
 
-char wifiSsid[32] = "ssid";
-char wifiPass[63] = "pass";
-uint32_t revRPM = 50000;
-uint32_t idleRPM = 1000;
-uint32_t idleTime_ms = 30000; // how long to idle the flywheels for
-uint32_t motorKv = 2550;
 pins_t pins = pins_v0_4_noid;
 // Options:
 // pins_v0_4_n20
 // pins_v0_4_noid
+// pins_v0_4_brushless
 // pins_v0_3_n20
 // pins_v0_3_noid
 // pins_v0_2
 // pins_v0_1
 // _noid means use the flywheel output to drive a solenoid pusher
-pusherType_t pusherType = PUSHER_SOLENOID_OPENLOOP;
-// PUSHER_MOTOR_CLOSEDLOOP or PUSHER_SOLENOID_OPENLOOP
-uint16_t burstLength = 3;
-uint8_t bufferMode = 1;
-// 0 = stop firing when trigger is released
-// 1 = complete current burst when trigger is released
-// 2 = fire as many bursts as trigger pulls
-// for full auto, set burstLength high (50+) and bufferMode = 0
-uint16_t firingDelay_ms = 200; // delay to allow flywheels to spin up before pushing dart
-uint16_t solenoidExtendTime_ms = 22;
-uint16_t solenoidRetractTime_ms = 78;
-
-// Advanced Configuration Variables
-
-uint16_t pusherStallTime_ms = 500;    // for PUSHER_MOTOR_CLOSEDLOOP, how long do you run the motor without seeing an update on the cycle control switch before you decide the motor is stalled?
-uint16_t spindownSpeed = 1;           // higher number makes the flywheels spin down faster when releasing the rev trigger
-bool revSwitchNormallyClosed = false; // should we invert rev signal?
-bool triggerSwitchNormallyClosed = false;
-bool cycleSwitchNormallyClosed = false;
-uint16_t debounceTime = 25; // ms
-char AP_SSID[32] = "Dettlaff";
-char AP_PW[32] = "KellyIndu";
-dshot_mode_t dshotMode = DSHOT300; // DSHOT_OFF to fall back to servo PWM
-uint16_t targetLoopTime_us = 1000; // microseconds
+// _brushless has pins.pusherEsc for PUSHER_BRUSHLESS, other boards run it as NO_PUSHER
+
+const config_t defaultConfig = {
+    .version = configVersion,
+    .revRPM = 50000,
+    .idleRPM = 1000,
+    .idleTime_ms = 30000, // how long to idle the flywheels for
+    .idleRPMMax = 0,      // 0 = fixed idle, otherwise idle faster during active play, down to idleRPM in lulls
+    .idleTimeMin_ms = 3000,
+    .idleActiveGap_ms = 5000, // revving again within this long idles at idleRPMMax
+    .idleLowBattery_mv = 0,   // at the ADC, idle at idleRPM below this, e.g. 1273 for 14.0V
+    .motorKv = 2550,
+    .pusherType = PUSHER_SOLENOID_OPENLOOP,
+    // PUSHER_MOTOR_CLOSEDLOOP, PUSHER_SOLENOID_OPENLOOP or PUSHER_BRUSHLESS (needs DShot and pins.pusherEsc)
+    .fireMode = FIRE_BURST,
+    // FIRE_BURST, FIRE_AUTO, FIRE_RAMPING_AUTO or FIRE_BINARY
+    .burstLength = 3,
+    .releaseMode = RELEASE_FINISH_BURST,
+    // RELEASE_CANCEL = stop firing when trigger is released
+    // RELEASE_FINISH_BURST = complete current burst when trigger is released
+    // RELEASE_QUEUE = fire as many bursts as trigger pulls
+    .rateOfFire_dpm = 0,      // darts per minute, 0 = as fast as the pusher can cycle, set one to cap it
+    .rampStartRate_dpm = 300, // for FIRE_RAMPING_AUTO, which needs a rateOfFire_dpm to ramp up to
+    .rampTime_ms = 1000,      // for FIRE_RAMPING_AUTO
+    .firingDelay_ms = 200,    // delay to allow flywheels to spin up before pushing dart
+    .solenoidExtendTime_ms = 22,
+    .solenoidRetractTime_ms = 78,
+
+    // Advanced Configuration Variables
+
+    .pusherStallTime_ms = 500,         // for PUSHER_MOTOR_CLOSEDLOOP and PUSHER_BRUSHLESS, how long do you run the motor without seeing an update on the cycle control switch before you decide the motor is stalled?
+    .spindownSpeed = 1,                // higher number makes the flywheels spin down faster when releasing the rev trigger
+    .pusherThrottle = 600,             // for PUSHER_BRUSHLESS, 0 - 1999
+    .pusherStrokeERevs = 42,           // for PUSHER_BRUSHLESS, motor pole pairs x gear ratio, 0 = brake on the cycle switch
+    .pusherBrakeTime_ms = 5,           // for PUSHER_BRUSHLESS, how long the ESC takes to brake it from pusherThrottle to a stop
+    .revSwitchNormallyClosed = false,  // should we invert rev signal?
+    .triggerSwitchNormallyClosed = false,
+    .cycleSwitchNormallyClosed = false,
+    .debounceTime = 25,                // ms
+    .wifiButtonHoldTime_ms = 2000,     // hold the button this long to turn WiFi and OTA on or off
+    .wifiSsid = "ssid",
+    .wifiPass = "pass",
+    .AP_SSID = "Dettlaff",
+    .AP_PW = "KellyIndu",
+    .dshotMode = DSHOT300,             // DSHOT_OFF to fall back to analog ESC protocols
+    .analogMode = ANALOG_PWM,          // used when dshotMode = DSHOT_OFF, every ESC takes PWM
+    // ANALOG_PWM, ANALOG_ONESHOT125, ANALOG_ONESHOT42 or ANALOG_MULTISHOT if the ESCs support them
+    .motorTarget_pct = {100, 100, 100, 100, 100, 100, 100, 100}, // e.g. a slower first stage in a multi stage blaster
+    .motorReversed = 0b00000000,       // bit n reverses motor n, DShot only
+    .targetLoopTime_us = 1000,         // microseconds
+    .escArmTime_ms = 300,              // how long to send zero throttle before the ESCs are considered armed
+    .bootTargetArmed_ms = 800,         // boot report fails if power on to armed takes longer than this
+    .failsafeTimeout_ms = 20,          // stop the motors and pusher if loop() stalls for this long
+};
 
 // End Configuration Variables
 
 uint32_t loopStartTimer_us = micros();
-uint16_t loopTime_us = targetLoopTime_us;
+uint16_t loopTime_us = 0;
 uint32_t time_ms = millis();
-uint32_t lastRevTime_ms = 0; // for calculating idling
-uint32_t pusherTimer_ms = 0;
-uint32_t targetRPM = 0;
-uint32_t throttleValue = 0;    // scale is 0 - 1999
-uint32_t batteryADC_mv = 1340; // voltage at the ADC, after the voltage divider
-uint16_t shotsToFire = 0;
-flywheelState_t flywheelState = STATE_IDLE;
-bool firing = false;
+uint32_t time_us = micros();
+uint32_t batteryADC_mv = 1340; // voltage at the ADC, after the voltage divider, assumed on boards without one
+uint32_t batterySum_mv = 0;
+uint8_t batterySamples = 0;
+const uint8_t batterySamplesPerUpdate = 64;
 bool closedLoopFlywheels = false;
-uint32_t scaledMotorKv = motorKv * 11; // motor kv * battery voltage resistor divider ratio
-
-const uint32_t maxThrottle = 1999;
+bool wifiButtonHandled = false;
+bool escArmed = false;
+uint32_t escArmStart_ms = 0;
+esp_timer_handle_t armingTimer = nullptr;
+volatile bool armingStreaming = false;
+
+// who may write the ESC and pusher outputs. Once the failsafe trips it owns them until loop()
+// starts its next tick, and a write that was already under way when it tripped is undone.
+enum outputOwner_t : uint8_t {
+  OUTPUTS_FREE,
+  OUTPUTS_WRITING, // loop() or the arming timer
+  OUTPUTS_FAILSAFE,
+};
+std::atomic<uint8_t> outputOwner(OUTPUTS_FREE);
+controlInputs_t controlInputs = {};
+controlOutputs_t controlOutputs = {};
+
+Controller controller;
+LatencyTracer latencyTracer;
 
 Bounce2::Button revSwitch = Bounce2::Button();
 Bounce2::Button triggerSwitch = Bounce2::Button();
 Bounce2::Button cycleSwitch = Bounce2::Button();
 Bounce2::Button button = Bounce2::Button();
 
-Servo servo1;
-Servo servo2;
-Servo servo3;
-Servo servo4;
-
-DShotRMT dshot1(pins.esc1, RMT_CHANNEL_1);
-DShotRMT dshot2(pins.esc2, RMT_CHANNEL_2);
-DShotRMT dshot3(pins.esc3, RMT_CHANNEL_3);
-DShotRMT dshot4(pins.esc4, RMT_CHANNEL_4);
-
-// void WiFiInit();
+MotorArray motors;
+EscTelemetry pusherTelemetry;
+static const uint8_t telemetryBytesPerTick = 32; // about 3 frames, more than can arrive in a tick
+static const uint32_t telemetryStale_us = 10000; // treat the pusher as stopped without fresh readings
+
+void applyConfig();
+bool outputsClaim();
+void outputsRelease();
+void stopOutputs();
+void sendThrottle(uint32_t throttle);
+void failsafe();
+void streamZeroThrottle(void *arg);
+void publishSnapshot();
+
+// Bench cases for the bench shell command, each runs one primitive of the control loop once
+volatile uint32_t benchSink = 0; // keeps results from being optimized out without touching the real outputs
+void benchButtonUpdate() { revSwitch.update(); }
+void benchDigitalWrite()
+{
+  if (pins.pusher) // unset is 0, the boot button
+  {
+    digitalWrite(pins.pusher, LOW);
+  }
+}
+void benchEscOutput() { sendThrottle(0); }
+void benchBatteryAdc()
+{
+  if (pins.batteryADC)
+  {
+    benchSink = analogReadMilliVolts(pins.batteryADC);
+  }
+}
+void benchThrottle() { benchSink = controller.openLoopThrottle(config->revRPM, batteryADC_mv); }
+void benchScheduler() { benchSink = controller.fireScheduler().shotDue(micros()); }
+void benchSnapshotPublish() { publishSnapshot(); }
+void benchSnapshotRead() { benchSink = controlSnapshot.read().tick; }
+
+const benchCase_t benchCases[] = {
+    {"Button::update", benchButtonUpdate},
+    {"digitalWrite", benchDigitalWrite},
+    {"esc output", benchEscOutput}, // every motor's DShot frame in the configured mode, or analog channel
+    {"analogReadMilliVolts", benchBatteryAdc},
+    {"throttle", benchThrottle},
+    {"FireScheduler::shotDue", benchScheduler},
+    {"snapshot publish", benchSnapshotPublish},
+    {"snapshot read", benchSnapshotRead},
+};
+
+const shellCommand_t shellCommands[] = {
+    SHELL_COMMAND("Solenoid", shellCommandSolenoid, "getExtendTime"),
+    SHELL_COMMAND("boot", shellCommandBoot, "boot phase timings"),
+    SHELL_COMMAND("wifi", shellCommandWifi, "start|stop|status"),
+    SHELL_COMMAND("config", shellCommandConfig, "list|get <name>|set <name> <value>|apply|save|defaults"),
+    SHELL_COMMAND("faults", shellCommandFaults, "control deadline misses, clear to reset"),
+    SHELL_COMMAND("bench", shellCommandBench, "[case] cycle counts of control loop primitives"),
+    SHELL_COMMAND("trace", shellCommandTrace, "dump|clear input trace for tools/replay"),
+    SHELL_COMMAND("status", shellCommandStatus, "latest control snapshot"),
+    SHELL_COMMAND("latency", shellCommandLatency, "[clear] trigger to shot latency histograms and rate of fire"),
+};
+
+bool blasterIdle()
+{
+  controlSnapshot_t status = controlSnapshot.read();
+  return status.armed && status.idle;
+}
 
 void setup()
 {
+  bootMark(BOOT_START);
+  configLoad();
+
+  // Start the ESCs first so their arming time overlaps the rest of setup()
+  motors.begin(pins.esc, pins.pusherEsc, config->dshotMode, config->analogMode, 1000000 / config->targetLoopTime_us);
+  uint32_t escRate_hz = motors.analogRate_hz(); // LEDC keeps sending zero throttle by itself
+  if (config->dshotMode != DSHOT_OFF)
+  {
+    // DShot frames are only sent when asked, so stream zero throttle from a timer until loop() takes over
+    const esp_timer_create_args_t armingTimerArgs = {
+        .callback = streamZeroThrottle,
+        .arg = nullptr,
+        .dispatch_method = ESP_TIMER_TASK,
+        .name = "escArming",
+    };
+    armingStreaming = true;
+    esp_timer_create(&armingTimerArgs, &armingTimer);
+    esp_timer_start_periodic(armingTimer, config->targetLoopTime_us);
+  }
+  escArmStart_ms = millis();
+  bootMark(BOOT_ESCS);
+
+  Serial.setTxBufferSize(2048); // so shell output is queued instead of holding up loop()
   Serial.begin(115200);
   Serial.println("Booting");
+  if (escRate_hz)
+  {
+    Serial.print("Analog ESC update rate ");
+    Serial.println(escRate_hz);
+  }
+  if (motors.hasPusher() && pins.telem)
+  {
+    Serial2.begin(115200, SERIAL_8N1, pins.telem, -1); // receive only, the pusher ESC's telemetry wire
+  }
 
   shell.attach(Serial);
-  shell.addCommand(F("Solenoid"), shellCommandSolenoid);
+  commandsBegin(shellCommands, sizeof(shellCommands) / sizeof(shellCommands[0]));
+  applyConfig();
+  bootMark(BOOT_SERIAL);
 
   if (pins.flywheel)
   {
     pinMode(pins.flywheel, OUTPUT);
     digitalWrite(pins.flywheel, HIGH);
   }
-  // WiFiInit();
   if (pins.revSwitch)
   {
     revSwitch.attach(pins.revSwitch, INPUT_PULLUP);
-    revSwitch.interval(debounceTime);
-    revSwitch.setPressedState(revSwitchNormallyClosed);
+    revSwitch.interval(config->debounceTime);
+    revSwitch.setPressedState(config->revSwitchNormallyClosed);
   }
   if (pins.triggerSwitch)
   {
     triggerSwitch.attach(pins.triggerSwitch, INPUT_PULLUP);
-    triggerSwitch.interval(debounceTime);
-    triggerSwitch.setPressedState(triggerSwitchNormallyClosed);
+    triggerSwitch.interval(config->debounceTime);
+    triggerSwitch.setPressedState(config->triggerSwitchNormallyClosed);
   }
   if (pins.cycleSwitch)
   {
     cycleSwitch.attach(pins.cycleSwitch, INPUT_PULLUP);
-    cycleSwitch.interval(debounceTime);
-    cycleSwitch.setPressedState(cycleSwitchNormallyClosed);
+    cycleSwitch.interval(config->debounceTime);
+    cycleSwitch.setPressedState(config->cycleSwitchNormallyClosed);
   }
+  // the button is on GPIO0 on every board, so it can't be skipped with the usual if (pins.button)
+  button.attach(pins.button, INPUT_PULLUP);
+  button.interval(config->debounceTime);
+  button.setPressedState(LOW);
+  if (pins.batteryADC)
+  {
+    batteryADC_mv = analogReadMilliVolts(pins.batteryADC);
+  }
+  bootMark(BOOT_INPUTS);
   if (pins.pusher)
   {
     pinMode(pins.pusher, OUTPUT);
     digitalWrite(pins.pusher, LOW);
-    pinMode(pins.pusherBrake, OUTPUT);
-    digitalWrite(pins.pusherBrake, LOW);
-  }
-  if (dshotMode == DSHOT_OFF)
-  {
-    ESP32PWM::allocateTimer(0);
-    ESP32PWM::allocateTimer(1);
-    ESP32PWM::allocateTimer(2);
-    ESP32PWM::allocateTimer(3);
-    servo1.setPeriodHertz(200);
-    servo2.setPeriodHertz(200);
-    servo3.setPeriodHertz(200);
-    servo4.setPeriodHertz(200);
-    servo1.attach(pins.esc1);
-    servo2.attach(pins.esc2);
-    servo3.attach(pins.esc3);
-    servo4.attach(pins.esc4);
   }
-  else
+  if (pins.pusherBrake)
   {
-    dshot1.begin(dshotMode, false); // bitrate & bidirectional
-    dshot2.begin(dshotMode, false);
-    dshot3.begin(dshotMode, false);
-    dshot4.begin(dshotMode, false);
+    pinMode(pins.pusherBrake, OUTPUT);
+    digitalWrite(pins.pusherBrake, LOW);
   }
+  bootMark(BOOT_PUSHER);
+  benchSetCases(benchCases, sizeof(benchCases) / sizeof(benchCases[0]), blasterIdle);
+  traceSetIdleCheck(blasterIdle);
+  configSetIdleCheck(blasterIdle);
+  deadlineBegin(config->failsafeTimeout_ms * 1000UL, failsafe);
+  bootMark(BOOT_SETUP);
 }
 
 void loop()
 {
   loopStartTimer_us = micros();
+  time_us = loopStartTimer_us;
   time_ms = millis();
+  if (deadlineTickStart(time_us))
+  {
+    // the failsafe already cut the motors and pusher, drop whatever we were doing
+    controller.reset();
+    controlOutputs = {};
+    traceFailsafe(time_us);
+    // ESCs take the lost signal as a disarm, so give them zero throttle for the arming time again
+    escArmed = false;
+    escArmStart_ms = time_ms;
+    outputOwner.store(OUTPUTS_FREE);
+    Serial.println("Control deadline missed, failsafe tripped");
+  }
+  // pick up config changes between shots so a burst never mixes settings
+  if (!controller.firing() && !controller.fireScheduler().pending() && configApplyPending())
+  {
+    applyConfig();
+  }
+  if (!escArmed && time_ms - escArmStart_ms >= config->escArmTime_ms)
+  {
+    escArmed = true;
+    motors.setDirections(config->motorReversed);
+    Serial.println("Ready");
+    if (bootTime_us(BOOT_ARMED) == 0) // not again when re-arming after the failsafe
+    {
+      bootMark(BOOT_ARMED);
+      bootReport(Serial);
+    }
+  }
   if (pins.revSwitch)
   {
     revSwitch.update();
@@ -163,230 +326,244 @@ void loop()
   {
     triggerSwitch.update();
   }
+  if (pins.cycleSwitch)
+  {
+    cycleSwitch.update();
+  }
 
-  if (triggerSwitch.pressed())
-  { // pressed and released are transitions, isPressed is for state
-    if (bufferMode == 0)
-    {
-      shotsToFire = burstLength;
-    }
-    else if (bufferMode == 1)
+  button.update();
+  if (button.isPressed() && !wifiButtonHandled && button.currentDuration() >= config->wifiButtonHoldTime_ms)
+  {
+    wifiButtonHandled = true;
+    if (networkState() == NET_OFF)
     {
-      if (shotsToFire < burstLength)
-      {
-        shotsToFire += burstLength;
-      }
+      networkStart();
     }
-    else if (bufferMode == 2)
+    else
     {
-      shotsToFire += burstLength;
+      networkStop();
     }
   }
-  else if (triggerSwitch.released())
+  else if (button.released())
   {
-    if (bufferMode == 0)
-    {
-      shotsToFire = 0;
-    }
+    wifiButtonHandled = false;
   }
 
-  switch (flywheelState)
+  controlInputs.time_us = time_us;
+  controlInputs.time_ms = time_ms;
+  controlInputs.armed = escArmed;
+  controlInputs.rev = revSwitch.isPressed();
+  controlInputs.trigger = triggerSwitch.isPressed();
+  controlInputs.cycle = cycleSwitch.isPressed();
+  if (pins.batteryADC)
   {
-
-  case STATE_IDLE:
-    if (triggerSwitch.isPressed() || revSwitch.isPressed())
+    // averaged, so ADC noise doesn't nudge the open loop throttle and fill the trace every tick
+    batterySum_mv += analogReadMilliVolts(pins.batteryADC);
+    if (++batterySamples == batterySamplesPerUpdate)
     {
-      targetRPM = revRPM;
-      lastRevTime_ms = time_ms;
-      flywheelState = STATE_ACCELERATING;
+      batteryADC_mv = batterySum_mv / batterySamplesPerUpdate;
+      batterySum_mv = 0;
+      batterySamples = 0;
     }
-    // idle flywheels
-    else if (time_ms < lastRevTime_ms + idleTime_ms && lastRevTime_ms > 0)
+  }
+  controlInputs.battery_mv = batteryADC_mv;
+  if (motors.hasPusher() && pins.telem)
+  {
+    for (uint8_t i = 0; i < telemetryBytesPerTick && Serial2.available(); i++)
     {
-      targetRPM = idleRPM;
+      pusherTelemetry.feed(Serial2.read(), time_us);
     }
-    // stop flywheels
-    else
+    controlInputs.pusherERPM = pusherTelemetry.eRPM(time_us, telemetryStale_us);
+  }
+  traceInputs(controlInputs, controller);
+  deadlineStageEnd(STAGE_INPUTS, micros());
+
+  bool wasPusher = controlOutputs.pusher;
+  bool wasBrake = controlOutputs.pusherBrake;
+  controller.tick(controlInputs, controlOutputs);
+  traceOutputs(controlOutputs);
+  latencyTracer.observe(controlInputs, controlOutputs, controller);
+  if (outputsClaim())
+  {
+    if (pins.pusher && controlOutputs.pusher != wasPusher)
     {
-      targetRPM = 0;
+      digitalWrite(pins.pusher, controlOutputs.pusher);
     }
-    break;
-
-  case STATE_ACCELERATING:
-    if ((closedLoopFlywheels) || (!closedLoopFlywheels && time_ms > lastRevTime_ms + firingDelay_ms))
+    if (pins.pusherBrake && controlOutputs.pusherBrake != wasBrake)
     {
-      flywheelState = STATE_FULLSPEED;
+      digitalWrite(pins.pusherBrake, controlOutputs.pusherBrake);
     }
+    outputsRelease();
+  }
+  switch (controlOutputs.event)
+  {
+  case CONTROL_EVENT_SOLENOID_EXTEND:
+    Serial.println("solenoid extending");
     break;
-
-  case STATE_FULLSPEED:
-    if (!revSwitch.isPressed() && shotsToFire == 0 && !firing)
-    {
-      flywheelState = STATE_IDLE;
-    }
-    else if (shotsToFire > 0 || firing)
-    {
-      switch (pusherType)
-      {
-
-      case PUSHER_MOTOR_CLOSEDLOOP:
-        cycleSwitch.update();
-        // start pusher stroke
-        if (shotsToFire > 0 && !firing)
-        {
-          digitalWrite(pins.pusher, HIGH);
-          digitalWrite(pins.pusherBrake, LOW);
-          firing = true;
-          pusherTimer_ms = time_ms;
-        }
-        // brake pusher
-        else if (firing && shotsToFire == 0 && cycleSwitch.pressed())
-        {
-          digitalWrite(pins.pusher, HIGH);
-          digitalWrite(pins.pusherBrake, HIGH);
-          firing = false;
-        }
-        else if (firing && shotsToFire > 0 && cycleSwitch.released())
-        {
-          shotsToFire = shotsToFire - 1;
-          pusherTimer_ms = time_ms;
-        }
-        // stall protection
-        else if (firing && time_ms > pusherTimer_ms + pusherStallTime_ms)
-        {
-          digitalWrite(pins.pusher, LOW); // let pusher coast
-          digitalWrite(pins.pusherBrake, LOW);
-          shotsToFire = 0;
-          firing = false;
-          Serial.println("Pusher motor stalled!");
-        }
-        break;
-
-      case PUSHER_SOLENOID_OPENLOOP:
-        // extend solenoid
-        if (shotsToFire > 0 && !firing && time_ms > pusherTimer_ms + solenoidRetractTime_ms)
-        {
-          digitalWrite(pins.pusher, HIGH);
-          firing = true;
-          shotsToFire -= 1;
-          pusherTimer_ms = time_ms;
-          Serial.println("solenoid extending");
-        }
-        // retract solenoid
-        else if (firing && time_ms > pusherTimer_ms + solenoidRetractTime_ms)
-        {
-          digitalWrite(pins.pusher, LOW);
-          firing = false;
-          pusherTimer_ms = time_ms;
-          Serial.println("solenoid retracting");
-        }
-        break;
-      }
-    }
+  case CONTROL_EVENT_SOLENOID_RETRACT:
+    Serial.println("solenoid retracting");
+    break;
+  case CONTROL_EVENT_PUSHER_STALLED:
+    Serial.println("Pusher motor stalled!");
+    break;
+  default:
     break;
   }
+  deadlineStageEnd(STAGE_FIRE_CONTROL, micros());
 
-  if (closedLoopFlywheels)
+  // loop() owns the ESCs from here on, wait out any arming frame still being sent from the timer task
+  if (armingTimer)
   {
-    // ray control code goes here
+    armingStreaming = false;
+    esp_timer_stop(armingTimer);
+    delayMicroseconds(200); // longer than one DSHOT150 frame
+    esp_timer_delete(armingTimer);
+    armingTimer = nullptr;
   }
-  else
+  // a reply takes most of a 1kHz tick, so only ask on every other one
+  static bool telemetryTick = false;
+  telemetryTick = !telemetryTick;
+  motors.setPusher(controlOutputs.pusherThrottle, telemetryTick);
+  sendThrottle(controlOutputs.throttle);
+  deadlineStageEnd(STAGE_OUTPUT, micros());
+  loopTime_us = micros() - loopStartTimer_us;
+  deadlineTickEnd(loopTime_us, config->targetLoopTime_us); // overruns are counted, see the faults shell command
+  publishSnapshot();
+  if (loopTime_us <= config->targetLoopTime_us)
   {
-    if (throttleValue == 0)
-    {
-      throttleValue = min(maxThrottle, maxThrottle * targetRPM / batteryADC_mv * 1000 / scaledMotorKv);
-    }
-    else
+    uint32_t now_us = micros();
+    uint32_t wake_us = controller.wakeTime_us(now_us, loopStartTimer_us + config->targetLoopTime_us);
+    if ((int32_t)(wake_us - now_us) > 0)
     {
-      throttleValue = max(min(maxThrottle, maxThrottle * targetRPM / batteryADC_mv * 1000 / scaledMotorKv),
-                          throttleValue - spindownSpeed);
+      delayMicroseconds(wake_us - now_us);
     }
   }
 
-  // send signal to ESCs
-  if (dshotMode == DSHOT_OFF)
+  deadlineStageStart(micros());
+  commandsService(Serial);
+  deadlineStageEnd(STAGE_SERVICE, micros());
+}
+
+// update everything derived from the config
+void applyConfig()
+{
+  pusherType_t pusherType = config->pusherType;
+  if (pusherType == PUSHER_BRUSHLESS && !motors.hasPusher())
   {
-    servo1.writeMicroseconds(throttleValue / 2 + 1000);
-    servo2.writeMicroseconds(throttleValue / 2 + 1000);
-    servo3.writeMicroseconds(throttleValue / 2 + 1000);
-    servo4.writeMicroseconds(throttleValue / 2 + 1000);
+    Serial.println("PUSHER_BRUSHLESS needs DShot and pins.pusherEsc, running without a pusher");
+    pusherType = NO_PUSHER;
   }
-  else
+  controller.configure({
+      .revRPM = config->revRPM,
+      .idleRPM = config->idleRPM,
+      .idleTime_ms = config->idleTime_ms,
+      .idleRPMMax = config->idleRPMMax,
+      .idleTimeMin_ms = config->idleTimeMin_ms,
+      .idleActiveGap_ms = config->idleActiveGap_ms,
+      .idleLowBattery_mv = config->idleLowBattery_mv,
+      .motorKv = config->motorKv,
+      .pusherType = pusherType,
+      .closedLoopFlywheels = closedLoopFlywheels,
+      .firingDelay_ms = config->firingDelay_ms,
+      .solenoidExtendTime_ms = config->solenoidExtendTime_ms,
+      .solenoidRetractTime_ms = config->solenoidRetractTime_ms,
+      .pusherStallTime_ms = config->pusherStallTime_ms,
+      .spindownSpeed = config->spindownSpeed,
+      .pusherThrottle = config->pusherThrottle,
+      .pusherStrokeERevs = config->pusherStrokeERevs,
+      .pusherBrakeTime_ms = config->pusherBrakeTime_ms,
+      .fire = {
+          .mode = config->fireMode,
+          .releaseMode = config->releaseMode,
+          .burstLength = config->burstLength,
+          .rateOfFire_dpm = config->rateOfFire_dpm,
+          .rampStartRate_dpm = config->rampStartRate_dpm,
+          .rampTime_ms = config->rampTime_ms,
+      },
+  });
+  motors.setTargets(config->motorTarget_pct);
+  // a trace is only replayable with the params it was recorded with
+  traceStart(controller, controlInputs, controlOutputs);
+}
+
+// false while the failsafe owns the outputs or the other writer is mid write
+bool outputsClaim()
+{
+  uint8_t expected = OUTPUTS_FREE;
+  return outputOwner.compare_exchange_strong(expected, OUTPUTS_WRITING);
+}
+
+void outputsRelease()
+{
+  uint8_t expected = OUTPUTS_WRITING;
+  if (!outputOwner.compare_exchange_strong(expected, OUTPUTS_FREE))
   {
-    dshot1.send_dshot_value(throttleValue + 48, NO_TELEMETRIC);
-    dshot2.send_dshot_value(throttleValue + 48, NO_TELEMETRIC);
-    dshot3.send_dshot_value(throttleValue + 48, NO_TELEMETRIC);
-    dshot4.send_dshot_value(throttleValue + 48, NO_TELEMETRIC);
+    stopOutputs(); // the failsafe tripped part way through, don't leave what was just written standing
   }
-  ArduinoOTA.handle();
-  loopTime_us = micros() - loopStartTimer_us;
-  if (loopTime_us > targetLoopTime_us)
+}
+
+// pusher off and no more ESC signal, safe from any task
+void stopOutputs()
+{
+  if (pins.pusher)
+  {
+    digitalWrite(pins.pusher, LOW);
+  }
+  if (pins.pusherBrake)
   {
-    Serial.print("loop over time, ");
-    Serial.println(loopTime_us);
+    digitalWrite(pins.pusherBrake, LOW);
   }
-  else
+  motors.stop();
+}
+
+// send signal to ESCs
+void sendThrottle(uint32_t throttle)
+{
+  if (outputsClaim())
   {
-    delayMicroseconds(max((long)(0), (long)(targetLoopTime_us - loopTime_us)));
+    motors.update(throttle);
+    outputsRelease();
   }
+}
+
+// called once from the deadline monitor's timer task when loop() stalls
+void failsafe()
+{
+  outputOwner.store(OUTPUTS_FAILSAFE);
+  stopOutputs();
+}
 
-  shell.executeIfInput();
+void streamZeroThrottle(void *arg)
+{
+  if (armingStreaming)
+  {
+    sendThrottle(0);
+  }
 }
 
-// void WiFiInit()
-// {
-//   WiFi.mode(WIFI_STA);
-//   WiFi.begin(wifiSsid, wifiPass);
-//   if (WiFi.waitForConnectResult() != WL_CONNECTED)
-//   {
-//     Serial.println("WiFi Connection Failed!");
-//     WiFi.mode(WIFI_AP);
-//     WiFi.softAP(AP_SSID, AP_PW);
-//   }
-//   else
-//   {
-//     Serial.print("WiFi Connected ");
-//     Serial.println(wifiSsid);
-//     ArduinoOTA.setHostname("Dettlaff");
-//     /*
-//         if(!MDNS.begin("dettlaff")) {
-//           Serial.println("Error starting mDNS");
-//           return;
-//         }
-//     */
-//     Serial.println(WiFi.localIP());
-
-//     // No authentication by default
-//     // ArduinoOTA.setPassword("admin");
-//   }
-
-//   ArduinoOTA
-//       .onStart([]()
-//                {
-//       String type;
-//       if (ArduinoOTA.getCommand() == U_FLASH) {
-//         type = "sketch";
-//       } else { // U_SPIFFS
-//         type = "filesystem";
-//       }
-//       // NOTE: if updating SPIFFS this would be the place to unmount SPIFFS using SPIFFS.end()
-//       Serial.println("Start updating " + type); })
-//       .onEnd([]()
-//              { Serial.println("\nEnd"); })
-//       .onProgress([](unsigned int progress, unsigned int total)
-//                   { Serial.printf("Progress: %u%%\r", (progress / (total / 100))); })
-//       .onError([](ota_error_t error)
-//                {
-//       Serial.printf("Error[%u]: ", error);
-//       if (error == OTA_AUTH_ERROR) Serial.println("Auth Failed");
-//       else if (error == OTA_BEGIN_ERROR) Serial.println("Begin Failed");
-//       else if (error == OTA_CONNECT_ERROR) Serial.println("Connect Failed");
-//       else if (error == OTA_RECEIVE_ERROR) Serial.println("Receive Failed");
-//       else if (error == OTA_END_ERROR) Serial.println("End Failed"); });
-
-//   ArduinoOTA.begin();
-
-//   Serial.println("Ready");
-//   Serial.print("IP address: ");
-//   Serial.println(WiFi.localIP());
-// }
+// everything outside the control tick reads this instead of the controller
+void publishSnapshot()
+{
+  static uint32_t tick = 0;
+  controlSnapshot.publish({
+      .tick = ++tick,
+      .time_us = controlInputs.time_us,
+      .loopTime_us = loopTime_us,
+      .battery_mv = (uint16_t)controlInputs.battery_mv,
+      .throttle = (uint16_t)controlOutputs.throttle,
+      .shotsQueued = controller.fireScheduler().shotsQueued(),
+      .shotsFired = controller.fireScheduler().shotsFired(),
+      .flywheelState = (uint8_t)controller.flywheelState(),
+      .armed = controlInputs.armed,
+      .rev = controlInputs.rev,
+      .trigger = controlInputs.trigger,
+      .cycle = controlInputs.cycle,
+      .pusher = controlOutputs.pusher,
+      .pusherBrake = controlOutputs.pusherBrake,
+      .firing = controller.firing(),
+      .idle = controller.idle(),
+      .lastLatency_us = latencyTracer.lastTotal_us(),
+      .idleRPM = controller.idleTargetRPM(),
+      .idleHold_ms = controller.idleHold_ms(),
+  });
+}
@@ -1,6 +1,6 @@
 #ifndef __types_h_
 #define __types_h_
-#include <Arduino.h>
+#include <stdint.h>
 
 enum flywheelState_t {
   STATE_IDLE,
@@ -8,6 +8,9 @@ enum flywheelState_t {
   STATE_FULLSPEED, // REV = wheels at full speed
 };
 
+// ESP32 RMT channel count, one per DShot motor
+static const uint8_t maxMotors = 8;
+
 typedef struct {
   int8_t revSwitch;
   int8_t triggerSwitch;
@@ -15,10 +18,8 @@ typedef struct {
   int8_t flywheel;
   int8_t pusher;
   int8_t pusherBrake;
-  int8_t esc1;
-  int8_t esc2;
-  int8_t esc3;
-  int8_t esc4;
+  int8_t esc[maxMotors]; // listed from the first, the first 0 ends the list
+  int8_t pusherEsc;      // for PUSHER_BRUSHLESS, takes the RMT channel after the flywheels
   int8_t telem;
   int8_t button;
   int8_t batteryADC;
@@ -27,6 +28,7 @@ typedef struct {
 enum pusherType_t {
   NO_PUSHER,
   PUSHER_MOTOR_CLOSEDLOOP,
-  PUSHER_SOLENOID_OPENLOOP
+  PUSHER_SOLENOID_OPENLOOP,
+  PUSHER_BRUSHLESS, // brushless motor on its own DShot ESC, with the cycle switch at home
 };
 #endif
@@ -0,0 +1,54 @@
+#ifndef BENCH_TIMING_H
+#define BENCH_TIMING_H
+
+#include <algorithm>
+#include <chrono>
+
+// Timing for the host benchmarks in tools/. Host numbers only compare variants and builds,
+// use the bench shell command for times on the blaster.
+
+typedef std::chrono::steady_clock benchClock;
+
+// runs repeated to take the best of, the others lost time to the OS
+static const int benchRuns = 5;
+
+static inline double benchElapsed_ns(benchClock::time_point start, benchClock::time_point end)
+{
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+}
+
+// how long body() takes
+template <typename Body>
+static double benchTime_ns(Body body)
+{
+  benchClock::time_point start = benchClock::now();
+  body();
+  return benchElapsed_ns(start, benchClock::now());
+}
+
+// what reading the clock twice costs, to take off times of very short pieces of work
+static inline double benchClockOverhead_ns()
+{
+  double overhead_ns = 1e9;
+  for (int i = 0; i < 1000; i++)
+  {
+    benchClock::time_point start = benchClock::now();
+    benchClock::time_point end = benchClock::now();
+    overhead_ns = std::min(overhead_ns, benchElapsed_ns(start, end));
+  }
+  return overhead_ns;
+}
+
+// the lowest of benchRuns results from run()
+template <typename Run>
+static double benchBestOf(Run run)
+{
+  double best = 1e18;
+  for (int i = 0; i < benchRuns; i++)
+  {
+    best = std::min(best, (double)run());
+  }
+  return best;
+}
+
+#endif // BENCH_TIMING_H
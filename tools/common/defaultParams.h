@@ -0,0 +1,33 @@
+#ifndef DEFAULT_PARAMS_H
+#define DEFAULT_PARAMS_H
+
+#include "Control/controller.h"
+
+// The controller params defaultConfig in src/main.cpp works out to, for the host tools in tools/.
+// Keep the two in step, tools start from these and only change what they are about.
+static inline controlParams_t defaultParams(pusherType_t pusherType)
+{
+  controlParams_t params = {};
+  params.revRPM = 50000;
+  params.idleRPM = 1000;
+  params.idleTime_ms = 30000;
+  params.idleRPMMax = 0;
+  params.idleTimeMin_ms = 3000;
+  params.idleActiveGap_ms = 5000;
+  params.idleLowBattery_mv = 0;
+  params.motorKv = 2550;
+  params.pusherType = pusherType;
+  params.closedLoopFlywheels = false;
+  params.firingDelay_ms = 200;
+  params.solenoidExtendTime_ms = 22;
+  params.solenoidRetractTime_ms = 78;
+  params.pusherStallTime_ms = 500;
+  params.spindownSpeed = 1;
+  params.pusherThrottle = 600;
+  params.pusherStrokeERevs = 42;
+  params.pusherBrakeTime_ms = 5;
+  params.fire = {FIRE_BURST, RELEASE_FINISH_BURST, 3, 0, 300, 1000};
+  return params;
+}
+
+#endif // DEFAULT_PARAMS_H
@@ -0,0 +1,143 @@
+// Host checks of the Controller's firing behaviour with a scripted pusher, for every pusher type:
+// shots are never closer together than rateOfFire_dpm allows, give or take a tick, and trigger
+// pulls before the ESCs are armed never fire later.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -Isrc tools/firetest/firetest.cpp src/Control/*.cpp src/FireControl/scheduler.cpp -o firetest
+//
+// Usage:
+//   firetest        prints each check, exits non zero if any failed
+
+#include <stdio.h>
+#include <vector>
+#include "Control/controller.h"
+#include "../common/defaultParams.h"
+
+static const uint32_t tick_us = 1000;
+static const uint32_t slack_us = 1000; // a stroke can start up to a tick after its deadline
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  failures += ok ? 0 : 1;
+}
+
+// a pusher that takes stroke_ms per stroke while driven, with the cycle switch pressed near home
+typedef struct {
+  uint32_t stroke_ms;
+  uint32_t position_us; // driven time into the current stroke
+  bool cycle() const { return position_us < stroke_ms * 200; }
+  void step(const controlOutputs_t &out, uint32_t dt_us)
+  {
+    if ((out.pusher && !out.pusherBrake) || out.pusherThrottle > 0)
+    {
+      position_us = (position_us + dt_us) % (stroke_ms * 1000);
+    }
+  }
+} scriptedPusher_t;
+
+static controlParams_t params(pusherType_t pusherType, fireMode_t mode, uint16_t rateOfFire_dpm)
+{
+  controlParams_t params = defaultParams(pusherType);
+  params.solenoidRetractTime_ms = 30; // so the solenoid keeps up with the fastest rate checked
+  params.fire.mode = mode;
+  params.fire.burstLength = 5;
+  params.fire.rateOfFire_dpm = rateOfFire_dpm;
+  return params;
+}
+
+// shot times over a session of trigger pulls, with loop()'s tick timing
+static std::vector<uint32_t> shots(const controlParams_t &params, uint32_t stroke_ms)
+{
+  Controller controller;
+  controller.configure(params);
+  scriptedPusher_t pusher = {stroke_ms, 0};
+  controlInputs_t in = {};
+  in.armed = true;
+  in.battery_mv = 1450;
+  controlOutputs_t out = {};
+  std::vector<uint32_t> times;
+  uint32_t fired = 0;
+  uint32_t now_us = 0;
+  while (now_us < 6000000)
+  {
+    in.time_us = now_us;
+    in.time_ms = now_us / 1000;
+    in.trigger = now_us % 2000000 < 1200000; // 1.2s pulls with 0.8s between, spinning down in between
+    in.cycle = pusher.cycle();
+    controller.tick(in, out);
+    if (controller.fireScheduler().shotsFired() != fired)
+    {
+      fired = controller.fireScheduler().shotsFired();
+      times.push_back(now_us);
+    }
+    uint32_t next_us = controller.wakeTime_us(now_us, now_us + tick_us);
+    pusher.step(out, next_us - now_us);
+    now_us = next_us;
+  }
+  return times;
+}
+
+// trigger tapped while disarmed, then rev alone once armed
+static void disarmedPull(pusherType_t pusherType, const char *name)
+{
+  Controller controller;
+  controller.configure(params(pusherType, FIRE_BURST, 0));
+  scriptedPusher_t pusher = {45, 0};
+  controlInputs_t in = {};
+  in.battery_mv = 1450;
+  controlOutputs_t out = {};
+  bool idleWhileDisarmed = true;
+  for (uint32_t now_ms = 0; now_ms < 4000; now_ms++)
+  {
+    in.time_us = now_ms * 1000;
+    in.time_ms = now_ms;
+    in.armed = now_ms >= 3000;
+    in.trigger = now_ms >= 100 && now_ms < 150;
+    in.rev = now_ms >= 3200 && now_ms < 3600;
+    in.cycle = pusher.cycle();
+    controller.tick(in, out);
+    pusher.step(out, 1000);
+    idleWhileDisarmed = idleWhileDisarmed && (in.armed || controller.idle());
+  }
+  char what[128];
+  snprintf(what, sizeof(what), "%-9s pull while disarmed never fires, %u shots", name,
+           (unsigned)controller.fireScheduler().shotsFired());
+  check(controller.fireScheduler().shotsFired() == 0 && idleWhileDisarmed, what);
+}
+
+int main()
+{
+  static const pusherType_t pusherTypes[] = {PUSHER_MOTOR_CLOSEDLOOP, PUSHER_SOLENOID_OPENLOOP, PUSHER_BRUSHLESS};
+  static const char *const pusherNames[] = {"none", "motor", "solenoid", "brushless"};
+  static const fireMode_t modes[] = {FIRE_BURST, FIRE_AUTO};
+  static const uint16_t rates_dpm[] = {300, 600, 900, 1200};
+  for (pusherType_t pusherType : pusherTypes)
+  {
+    for (fireMode_t mode : modes)
+    {
+      for (uint16_t rate_dpm : rates_dpm)
+      {
+        std::vector<uint32_t> times = shots(params(pusherType, mode, rate_dpm), 45);
+        uint32_t period_us = 60000000UL / rate_dpm;
+        uint32_t closest_us = UINT32_MAX;
+        for (size_t i = 1; i < times.size(); i++)
+        {
+          closest_us = times[i] - times[i - 1] < closest_us ? times[i] - times[i - 1] : closest_us;
+        }
+        char what[128];
+        snprintf(what, sizeof(what), "%-9s %-5s %4u dpm, %3u shots, closest %6.1f ms, cap %6.1f ms",
+                 pusherNames[pusherType], mode == FIRE_AUTO ? "auto" : "burst", rate_dpm, (unsigned)times.size(),
+                 closest_us / 1000.0, period_us / 1000.0);
+        check(times.size() > 10 && closest_us + slack_us >= period_us, what);
+      }
+    }
+  }
+  for (pusherType_t pusherType : pusherTypes)
+  {
+    disarmedPull(pusherType, pusherNames[pusherType]);
+  }
+  return failures ? 1 : 0;
+}
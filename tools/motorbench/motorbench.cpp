@@ -0,0 +1,67 @@
+// Times the per-tick DShot output work of the motor array on the host at 2, 4, 6 and 8 motors:
+// scaling the throttle per motor, encoding the frames and copying each into its channel's
+// memory, as MotorArray::update() does before starting the channels.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -Isrc tools/motorbench/motorbench.cpp src/Esc/dshotFrames.cpp -o motorbench
+//
+// Usage:
+//   motorbench [ticks]
+//
+// Starting the RMT channels is a register write per motor and isn't included. Timing is from
+// tools/common/benchTiming.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Esc/dshotFrames.h"
+#include "../common/benchTiming.h"
+
+static uint32_t channelMemory[maxMotors][64]; // stands in for the RMT RAM blocks
+
+static double timeTicks(DshotFrames &frames, uint8_t motors, const uint8_t *targets_pct, uint32_t ticks)
+{
+  return benchBestOf([&]()
+                     {
+    double elapsed_ns = benchTime_ns([&]()
+                                     {
+      for (uint32_t tick = 0; tick < ticks; tick++)
+      {
+        uint32_t throttle = tick % 2000;
+        uint16_t values[maxMotors];
+        for (uint8_t i = 0; i < motors; i++)
+        {
+          values[i] = throttle * targets_pct[i] / 100 + 48;
+        }
+        frames.prepare(values, motors);
+        for (uint8_t i = 0; i < motors; i++)
+        {
+          memcpy(channelMemory[i], frames.frame(i).items, sizeof(dshotFrame_t));
+        }
+      } });
+    return elapsed_ns / ticks; });
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t ticks = argc >= 2 ? atoi(argv[1]) : 1000000;
+  if (ticks == 0)
+  {
+    fprintf(stderr, "usage: %s [ticks]\n", argv[0]);
+    return 2;
+  }
+
+  DshotFrames frames;
+  frames.configure(300, 80000000);
+  static const uint8_t sameTargets[maxMotors] = {100, 100, 100, 100, 100, 100, 100, 100};
+  static const uint8_t stagedTargets[maxMotors] = {60, 60, 80, 80, 100, 100, 90, 70}; // multi stage, pairs share a speed
+
+  printf("%6s %14s %14s %14s\n", "motors", "same ns/tick", "staged ns/tick", "ns per motor");
+  for (uint8_t motors = 2; motors <= maxMotors; motors += 2)
+  {
+    double same_ns = timeTicks(frames, motors, sameTargets, ticks);
+    double staged_ns = timeTicks(frames, motors, stagedTargets, ticks);
+    printf("%6u %14.1f %14.1f %14.1f\n", motors, same_ns, staged_ns, same_ns / motors);
+  }
+  return channelMemory[0][16] != 0; // keeps the copies from being optimized out
+}
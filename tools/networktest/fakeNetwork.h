@@ -0,0 +1,43 @@
+#ifndef FAKE_NETWORK_H
+#define FAKE_NETWORK_H
+
+#include <atomic>
+#include "Network/networkService.h"
+
+// Stand-in for the radio, counts the calls NetworkService makes and connects the station once
+// told to. Also counts how many callers are inside it at once, which is more than one only if
+// two runners exist.
+
+class FakeNetworkBackend : public NetworkBackend
+{
+public:
+  void beginStation() override { enter(); stations++; up = true; leave(); }
+  bool stationConnected() override { return connect.load(); }
+  void beginAccessPoint() override { enter(); accessPoints++; leave(); }
+  void beginOta() override { enter(); otaStarts++; leave(); }
+  void handleOta() override { enter(); otaHandled++; leave(); }
+  void shutdown() override { enter(); shutdowns++; up = false; leave(); }
+
+  std::atomic<bool> connect{false};
+  std::atomic<uint32_t> stations{0};
+  std::atomic<uint32_t> accessPoints{0};
+  std::atomic<uint32_t> otaStarts{0};
+  std::atomic<uint32_t> otaHandled{0};
+  std::atomic<uint32_t> shutdowns{0};
+  std::atomic<bool> up{false}; // brought up and not shut down since
+  std::atomic<uint32_t> overlaps{0};
+
+private:
+  void enter()
+  {
+    if (inside.fetch_add(1) != 0)
+    {
+      overlaps++;
+    }
+  }
+  void leave() { inside--; }
+
+  std::atomic<uint32_t> inside{0};
+};
+
+#endif // FAKE_NETWORK_H
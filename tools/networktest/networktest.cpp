@@ -0,0 +1,157 @@
+// Drives NetworkService against a fake backend on the host to check the start / stop sequencing,
+// including requests that arrive before the runner task has got going, and a stress run with
+// the requests and the runners on separate threads like loop() and the network task.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -pthread -Isrc tools/networktest/networktest.cpp src/Network/networkService.cpp -o networktest
+//
+// Usage:
+//   networktest        prints each check, exits non zero if any failed
+
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "fakeNetwork.h"
+
+static const uint32_t stationTimeout_ms = 10000;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what)
+{
+  printf("%s %s\n", ok ? "ok  " : "FAIL", what);
+  failures += ok ? 0 : 1;
+}
+
+// what the network task does, with time passed in
+static void runner(NetworkService &service, uint32_t &now_ms, uint32_t period_ms)
+{
+  do
+  {
+    service.start(now_ms);
+    while (service.step(now_ms))
+    {
+      now_ms += period_ms;
+      std::this_thread::yield();
+    }
+  } while (service.releaseRunner());
+}
+
+static void accessPointFallback()
+{
+  FakeNetworkBackend backend;
+  NetworkService service(backend, stationTimeout_ms);
+  service.requestStart();
+  check(service.claimRunner(), "first start claims the runner");
+  service.start(0);
+  check(service.state() == NET_CONNECTING && backend.stations == 1, "start brings the station up");
+  service.step(stationTimeout_ms);
+  check(service.state() == NET_CONNECTING, "still connecting at the timeout");
+  service.step(stationTimeout_ms + 1);
+  check(service.state() == NET_ACCESS_POINT && backend.accessPoints == 1 && backend.otaStarts == 1,
+        "access point after the timeout");
+  service.step(stationTimeout_ms + 2);
+  check(backend.otaHandled == 1, "OTA serviced while up");
+  service.requestStop();
+  check(!service.step(stationTimeout_ms + 3) && service.state() == NET_OFF && backend.shutdowns == 1,
+        "stop shuts down");
+  check(!service.releaseRunner(), "runner exits once stopped");
+}
+
+static void stationConnects()
+{
+  FakeNetworkBackend backend;
+  NetworkService service(backend, stationTimeout_ms);
+  service.requestStart();
+  service.claimRunner();
+  service.start(0);
+  backend.connect = true;
+  service.step(100);
+  check(service.state() == NET_STATION && backend.accessPoints == 0 && backend.otaStarts == 1, "station connects");
+}
+
+static void stopBeforeRunnerRuns()
+{
+  FakeNetworkBackend backend;
+  NetworkService service(backend, stationTimeout_ms);
+  service.requestStart();
+  service.claimRunner();
+  service.requestStop();
+  uint32_t now_ms = 0;
+  runner(service, now_ms, 10);
+  check(backend.stations == 0 && backend.shutdowns == 0 && service.state() == NET_OFF,
+        "stop before the runner ran sticks");
+  service.requestStart();
+  check(service.claimRunner(), "start after that claims a new runner");
+}
+
+static void startWhileRunnerAlive()
+{
+  FakeNetworkBackend backend;
+  NetworkService service(backend, stationTimeout_ms);
+  service.requestStart();
+  service.claimRunner();
+  service.start(0);
+  service.requestStop();
+  check(!service.step(10), "stopped");
+  // started again before the runner got round to exiting, so no new runner is made
+  service.requestStart();
+  check(!service.claimRunner(), "start while the runner is alive doesn't claim another");
+  check(service.releaseRunner(), "runner goes round again for the late start");
+  service.start(20);
+  check(service.state() == NET_CONNECTING && backend.stations == 2, "brought up again");
+  service.requestStart();
+  service.start(30);
+  check(backend.stations == 2, "start while up does nothing");
+}
+
+static void stress()
+{
+  FakeNetworkBackend backend;
+  NetworkService service(backend, 5);
+  std::vector<std::thread> runners;
+  uint32_t random = 2463534242u;
+  for (int i = 0; i < 20000; i++)
+  {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    backend.connect = random & 0x100;
+    if (random & 1)
+    {
+      service.requestStart();
+      if (service.claimRunner())
+      {
+        runners.emplace_back([&service]()
+                             {
+          uint32_t now_ms = 0;
+          runner(service, now_ms, 1); });
+      }
+    }
+    else
+    {
+      service.requestStop();
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(random % 50));
+  }
+  service.requestStop();
+  for (std::thread &thread : runners)
+  {
+    thread.join();
+  }
+  check(backend.overlaps == 0, "never two runners at once");
+  check(service.state() == NET_OFF && !backend.up && backend.stations == backend.shutdowns,
+        "every bring up shut down after the last stop");
+  printf("     %zu runners, %u bring ups\n", runners.size(), backend.stations.load());
+}
+
+int main()
+{
+  accessPointFallback();
+  stationConnects();
+  stopBeforeRunnerRuns();
+  startWhileRunnerAlive();
+  stress();
+  return failures ? 1 : 0;
+}
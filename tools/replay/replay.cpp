@@ -0,0 +1,261 @@
+// Replays input traces dumped with the "trace dump" shell command through the firmware's
+// Controller and prints the resulting ESC and pusher output sequence.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -Isrc tools/replay/replay.cpp src/Control/*.cpp src/FireControl/scheduler.cpp -o replay
+//
+// Usage:
+//   replay trace.txt            every output change, "<time_us> <output> <value>", diffable between builds
+//   replay -s trace1.txt ...    one summary line per trace with a hash of the output sequence
+//
+// The Controller starts from the state checkpointed at the start of the trace and ticks when
+// the blaster's did, with the same micros() and millis(). Ticks where nothing changed were only
+// counted, those are spread evenly up to the last of them, so the outputs are checked against
+// the recorded ones on every tick and any tick that differs is reported on stderr. Traces
+// without the start state are refused rather than replayed from a fresh Controller.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include "Control/controller.h"
+#include "Diagnostics/trace.h"
+
+typedef struct {
+  controlParams_t params;
+  controlState_t state;
+  controlInputs_t start;
+  traceOutputs_t outputs; // at the start
+  uint32_t end_us; // the last tick
+  std::vector<traceEvent_t> events;
+} trace_t;
+
+static bool loadTrace(const char *path, trace_t &trace)
+{
+  FILE *file = fopen(path, "r");
+  if (file == nullptr)
+  {
+    fprintf(stderr, "%s: can't open\n", path);
+    return false;
+  }
+  char line[512];
+  bool haveParams = false;
+  bool haveState = false;
+  bool haveStart = false;
+  trace.events.clear();
+  trace.outputs = {};
+  while (fgets(line, sizeof(line), file))
+  {
+    unsigned version, time_us, time_ms, type, value, armed, rev, trigger, cycle, battery_mv, pusherERPM;
+    unsigned throttle, pusher, brake, pusherThrottle;
+    int throttleStep;
+    if (sscanf(line, "trace %u", &version) == 1 && version != traceVersion)
+    {
+      fprintf(stderr, "%s: trace version %u, expected %u\n", path, version, traceVersion);
+      fclose(file);
+      return false;
+    }
+    else if (strncmp(line, "params ", 7) == 0)
+    {
+      haveParams = controlParamsParse(line + 7, trace.params);
+    }
+    else if (strncmp(line, "state ", 6) == 0)
+    {
+      haveState = controlStateParse(line + 6, trace.state);
+    }
+    else if (sscanf(line, "start %u %u %u %u %u %u %u %u", &time_us, &time_ms, &armed, &rev, &trigger, &cycle, &battery_mv,
+                    &pusherERPM) == 8)
+    {
+      trace.start = {time_us, time_ms, armed != 0, rev != 0, trigger != 0, cycle != 0, battery_mv, pusherERPM};
+      haveStart = true;
+    }
+    else if (sscanf(line, "outputs %u %u %u %u %d", &throttle, &pusher, &brake, &pusherThrottle, &throttleStep) == 5)
+    {
+      trace.outputs.outputs = {throttle, pusher != 0, brake != 0, pusherThrottle, CONTROL_EVENT_NONE};
+      trace.outputs.throttleStep = throttleStep;
+    }
+    else if (sscanf(line, "e %u %u %u", &time_us, &type, &value) == 3)
+    {
+      trace.events.push_back({time_us, (uint8_t)type, (uint16_t)value});
+    }
+    // anything else is shell noise around the dump
+  }
+  fclose(file);
+  if (!haveParams || !haveStart)
+  {
+    fprintf(stderr, "%s: missing params or start line\n", path);
+    return false;
+  }
+  if (!haveState)
+  {
+    fprintf(stderr, "%s: no controller state for the start of the trace, can't replay it faithfully\n", path);
+    return false;
+  }
+  trace.end_us = trace.start.time_us;
+  for (const traceEvent_t &event : trace.events)
+  {
+    if (event.type == TRACE_TICK || event.type == TRACE_QUIET)
+    {
+      trace.end_us = event.time_us;
+    }
+  }
+  return true;
+}
+
+static uint64_t hashStep(uint64_t hash, uint32_t value)
+{
+  // FNV-1a
+  for (int i = 0; i < 4; i++)
+  {
+    hash ^= (value >> (i * 8)) & 0xff;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+typedef struct {
+  uint64_t ticks;
+  uint64_t changes;
+  uint64_t hash;
+  uint64_t offRecord; // ticks whose outputs differ from the recorded ones
+  uint32_t firstOffRecord_us;
+} replayResult_t;
+
+class Replayer {
+public:
+  Replayer(const trace_t &trace, bool print) : trace(trace), print(print)
+  {
+    controller.configure(trace.params);
+    controller.restoreState(trace.state);
+    inputs = trace.start;
+    recorded = trace.outputs;
+    result = {0, 0, 14695981039346656037ULL, 0, 0};
+  }
+
+  replayResult_t run()
+  {
+    for (const traceEvent_t &event : trace.events)
+    {
+      if (event.type == TRACE_FAILSAFE)
+      {
+        controller.reset();
+        outputs = {};
+        recorded = {};
+      }
+      else if (event.type == TRACE_QUIET)
+      {
+        quietTicks(event.time_us, event.value);
+      }
+      else if (!traceApplyOutput(recorded, event))
+      {
+        traceApplyEvent(inputs, event);
+        if (event.type == TRACE_TICK)
+        {
+          tick();
+        }
+      }
+    }
+    return result;
+  }
+
+private:
+  const trace_t &trace;
+  bool print;
+  Controller controller;
+  controlInputs_t inputs;
+  controlOutputs_t outputs = {};
+  controlOutputs_t previous = {};
+  traceOutputs_t recorded;
+  replayResult_t result;
+
+  // evenly spaced from the tick before to the last quiet one, millis() keeps the sub-millisecond
+  // phase micros() had at the tick before, which holds on the ESP32 where both count the same timer
+  void quietTicks(uint32_t end_us, uint16_t ticks)
+  {
+    uint32_t from_us = inputs.time_us;
+    uint32_t from_ms = inputs.time_ms;
+    uint32_t phase_us = from_us - from_ms * 1000;
+    if (phase_us >= 1000)
+    {
+      phase_us = 0; // not the same timer after all
+    }
+    for (uint32_t i = 1; i <= ticks; i++)
+    {
+      uint32_t since_us = (uint64_t)(end_us - from_us) * i / ticks;
+      inputs.time_us = from_us + since_us;
+      inputs.time_ms = from_ms + (phase_us + since_us) / 1000;
+      tick();
+    }
+  }
+
+  void tick()
+  {
+    uint32_t now_us = inputs.time_us;
+    controller.tick(inputs, outputs);
+    traceOutputsTicked(recorded);
+    result.ticks++;
+
+    const uint32_t values[] = {outputs.throttle, outputs.pusher, outputs.pusherBrake, outputs.pusherThrottle};
+    const uint32_t previousValues[] = {previous.throttle, previous.pusher, previous.pusherBrake, previous.pusherThrottle};
+    const uint32_t recordedValues[] = {recorded.outputs.throttle, recorded.outputs.pusher, recorded.outputs.pusherBrake,
+                                       recorded.outputs.pusherThrottle};
+    static const char *const names[] = {"throttle", "pusher", "brake", "pusherThrottle"};
+    bool offRecord = false;
+    for (int i = 0; i < 4; i++)
+    {
+      if (values[i] != previousValues[i] || result.ticks == 1)
+      {
+        result.changes++;
+        result.hash = hashStep(hashStep(hashStep(result.hash, now_us - trace.start.time_us), i), values[i]);
+        if (print)
+        {
+          printf("%u %s %u\n", now_us, names[i], values[i]);
+        }
+      }
+      offRecord = offRecord || values[i] != recordedValues[i];
+    }
+    if (offRecord && result.offRecord++ == 0)
+    {
+      result.firstOffRecord_us = now_us;
+    }
+    previous = outputs;
+  }
+};
+
+int main(int argc, char **argv)
+{
+  bool summary = argc >= 2 && strcmp(argv[1], "-s") == 0;
+  int first = summary ? 2 : 1;
+  if (first >= argc)
+  {
+    fprintf(stderr, "usage: %s [-s] trace...\n", argv[0]);
+    return 2;
+  }
+
+  int failures = 0;
+  for (int i = first; i < argc; i++)
+  {
+    trace_t trace;
+    if (!loadTrace(argv[i], trace))
+    {
+      failures++;
+      continue;
+    }
+    clock_t started = clock();
+    replayResult_t result = Replayer(trace, !summary).run();
+    double elapsed_s = (double)(clock() - started) / CLOCKS_PER_SEC;
+    if (summary)
+    {
+      double simulated_s = (trace.end_us - trace.start.time_us) / 1e6;
+      printf("%s %016llx %llu ticks %llu changes %.0fx realtime\n", argv[i], (unsigned long long)result.hash,
+             (unsigned long long)result.ticks, (unsigned long long)result.changes,
+             elapsed_s > 0 ? simulated_s / elapsed_s : 0);
+    }
+    if (result.offRecord)
+    {
+      fprintf(stderr, "%s: %llu ticks differ from the recorded outputs, the first at %u\n", argv[i],
+              (unsigned long long)result.offRecord, result.firstOffRecord_us);
+    }
+  }
+  return failures ? 1 : 0;
+}
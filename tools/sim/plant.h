@@ -0,0 +1,274 @@
+#ifndef PLANT_H
+#define PLANT_H
+
+// Physical model of a blaster for the host simulator: battery, ESCs, brushless flywheel motors,
+// darts passing through the wheels, and a solenoid, N20 or brushless pusher. SI units throughout,
+// stepped at a sub-millisecond dt independent of the controller tick.
+
+#include <math.h>
+#include <stdint.h>
+
+typedef struct {
+  // battery
+  double batteryOpenCircuit_v;
+  double batteryResistance_ohm;
+  // flywheel motors, all identical and driven with the same throttle
+  int motorCount;
+  double motorKv_rpmPerVolt;
+  double motorResistance_ohm;
+  double flywheelInertia_kgm2; // per motor, wheel plus rotor
+  double flywheelRadius_m;
+  double frictionTorque_nm;
+  double escTimeConstant_s; // lag between a new throttle and the ESC's applied duty
+  double escCurrentLimit_a; // per motor
+  // darts
+  double dartMass_kg;
+  double dartGrip;       // fraction of wheel surface speed the dart leaves with
+  double dartEfficiency; // fraction of the energy taken from the wheels that ends up in the dart
+  // pushers
+  double solenoidTravel_s;  // energized to dart reaching the wheels
+  double solenoidCurrent_a;
+  double n20Stroke_s;       // one full stroke at batteryOpenCircuit_v
+  double n20HomeFraction;   // part of the stroke around home where the cycle switch is pressed
+  double n20Current_a;
+  double brushlessFullERPM;  // brushless pusher at full throttle and batteryOpenCircuit_v
+  double brushlessStrokeERevs;
+  double brushlessSpinup_s;  // time constant towards the throttle's speed
+  double brushlessBrake_s;   // full speed to stopped at zero throttle, braking is close to linear
+  double brushlessCurrent_a; // while driven
+} plantParams_t;
+
+static const plantParams_t defaultPlant = {
+    16.0,    // batteryOpenCircuit_v, 4S
+    0.03,    // batteryResistance_ohm
+    2,       // motorCount
+    2550,    // motorKv_rpmPerVolt
+    0.06,    // motorResistance_ohm
+    6.5e-6,  // flywheelInertia_kgm2
+    0.0175,  // flywheelRadius_m
+    0.002,   // frictionTorque_nm
+    0.002,   // escTimeConstant_s
+    40,      // escCurrentLimit_a
+    0.001,   // dartMass_kg
+    0.75,    // dartGrip
+    0.5,     // dartEfficiency
+    0.012,   // solenoidTravel_s
+    3.0,     // solenoidCurrent_a
+    0.050,   // n20Stroke_s
+    0.15,    // n20HomeFraction
+    1.5,     // n20Current_a
+    150000,  // brushlessFullERPM
+    42,      // brushlessStrokeERevs, 7 pole pairs through 6:1
+    0.008,   // brushlessSpinup_s
+    0.015,   // brushlessBrake_s
+    6.0,     // brushlessCurrent_a
+};
+
+class Plant
+{
+public:
+  explicit Plant(const plantParams_t &params) : p(params) { batteryVoltage = p.batteryOpenCircuit_v; }
+
+  // controller outputs, held until changed
+  uint32_t throttle = 0; // 0 - 1999
+  bool pusher = false;
+  bool pusherBrake = false;
+  uint32_t pusherThrottle = 0; // brushless pusher, 0 - 1999, 0 brakes
+  bool n20 = false;       // false = solenoid
+  bool brushless = false; // takes priority over n20, shares its cycle switch
+
+  // sensed state for the controller
+  bool cycleSwitch() const
+  {
+    return n20 || brushless ? n20Phase < p.n20HomeFraction / 2 || n20Phase > 1 - p.n20HomeFraction / 2 : false;
+  }
+  // what the ESC's telemetry would say, which has a resolution of 100
+  uint32_t pusherERPM() const { return brushless ? (uint32_t)(brushlessERPM / 100) * 100 : 0; }
+  double pusherPhase() const { return n20Phase; }
+  uint32_t batteryAdc_mv() const { return (uint32_t)(batteryVoltage * 1000 / 11); } // matches the board's divider
+
+  // nothing to resolve finely while the pusher stands still, only the flywheels move
+  bool pusherAtRest() const
+  {
+    if (brushless)
+    {
+      return pusherThrottle == 0 && brushlessERPM == 0;
+    }
+    return n20 ? (!pusher || pusherBrake) && n20Speed < 0.01 : !pusher;
+  }
+
+  double wheelRPM() const { return omega * 60 / (2 * M_PI); }
+  double battery_v() const { return batteryVoltage; }
+
+  // set when a dart leaves during the last step
+  bool dartFired = false;
+  double dartVelocity_mps = 0;
+  uint32_t dartsFired = 0;
+
+  void reset()
+  {
+    omega = 0;
+    duty = 0;
+    solenoidOn_s = 0;
+    solenoidFed = false;
+    n20Phase = 0;
+    n20Speed = 0;
+    brushlessERPM = 0;
+    dartsFired = 0;
+    batteryVoltage = p.batteryOpenCircuit_v;
+  }
+
+  void step(double dt)
+  {
+    dartFired = false;
+    double current = 0;
+    if (dt != lagDt)
+    {
+      setLags(dt);
+    }
+
+    // ESC duty follows the throttle with a first order lag
+    double targetDuty = throttle / 1999.0;
+    duty += (targetDuty - duty) * escLag;
+
+    // motor: back EMF from speed, torque from current, ESC input current scales with duty
+    double kv = p.motorKv_rpmPerVolt * 2 * M_PI / 60; // rad/s per volt
+    double backEmf = omega / kv;
+    double motorCurrent = (duty * batteryVoltage - backEmf) / p.motorResistance_ohm;
+    motorCurrent = fmax(-p.escCurrentLimit_a, fmin(p.escCurrentLimit_a, motorCurrent));
+    double torque = motorCurrent / kv - (omega > 0 ? p.frictionTorque_nm : 0);
+    omega += torque / p.flywheelInertia_kgm2 * dt;
+    if (omega < 0)
+    {
+      omega = 0;
+    }
+    current += p.motorCount * motorCurrent * duty;
+
+    if (brushless)
+    {
+      stepBrushless(dt, current);
+    }
+    else if (n20)
+    {
+      stepN20(dt, current);
+    }
+    else
+    {
+      stepSolenoid(dt, current);
+    }
+
+    batteryVoltage = fmax(0.1, p.batteryOpenCircuit_v - current * p.batteryResistance_ohm);
+  }
+
+private:
+  // the first order lags' step for a dt, exp() is most of a step's cost otherwise
+  void setLags(double dt)
+  {
+    lagDt = dt;
+    escLag = 1 - exp(-dt / p.escTimeConstant_s);
+    n20Drive = 1 - exp(-dt / 0.005);
+    n20Brake = exp(-dt / 0.001);
+    n20Coast = exp(-dt / 0.02);
+    brushlessSpinup = 1 - exp(-dt / p.brushlessSpinup_s);
+  }
+
+  void fireDart()
+  {
+    // the dart leaves with a fraction of the wheel surface speed and takes energy from every wheel
+    double velocity = omega * p.flywheelRadius_m * p.dartGrip;
+    double energy = 0.5 * p.dartMass_kg * velocity * velocity / p.dartEfficiency / p.motorCount;
+    double wheelEnergy = 0.5 * p.flywheelInertia_kgm2 * omega * omega - energy;
+    omega = wheelEnergy > 0 ? sqrt(2 * wheelEnergy / p.flywheelInertia_kgm2) : 0;
+    dartFired = true;
+    dartVelocity_mps = velocity;
+    dartsFired++;
+  }
+
+  void stepSolenoid(double dt, double &current)
+  {
+    if (pusher)
+    {
+      current += p.solenoidCurrent_a;
+      solenoidOn_s += dt;
+      // a dart only feeds if the solenoid stays on long enough to push it into the wheels
+      if (!solenoidFed && solenoidOn_s >= p.solenoidTravel_s)
+      {
+        solenoidFed = true;
+        fireDart();
+      }
+    }
+    else
+    {
+      solenoidOn_s = 0;
+      solenoidFed = false;
+    }
+  }
+
+  void stepN20(double dt, double &current)
+  {
+    // speed follows battery voltage, brake stops it within a few degrees, coasting slows it gently
+    double fullSpeed = batteryVoltage / p.batteryOpenCircuit_v / p.n20Stroke_s; // strokes per second
+    if (pusher && !pusherBrake)
+    {
+      n20Speed += (fullSpeed - n20Speed) * n20Drive;
+      current += p.n20Current_a;
+    }
+    else if (pusherBrake)
+    {
+      n20Speed *= n20Brake;
+    }
+    else
+    {
+      n20Speed *= n20Coast;
+    }
+    advanceStroke(n20Speed * dt);
+  }
+
+  void stepBrushless(double dt, double &current)
+  {
+    double fullERPM = p.brushlessFullERPM * batteryVoltage / p.batteryOpenCircuit_v;
+    if (pusherThrottle > 0)
+    {
+      brushlessERPM += (fullERPM * pusherThrottle / 1999.0 - brushlessERPM) * brushlessSpinup;
+      current += p.brushlessCurrent_a * pusherThrottle / 1999.0;
+    }
+    else
+    {
+      brushlessERPM = fmax(0, brushlessERPM - p.brushlessFullERPM / p.brushlessBrake_s * dt);
+    }
+    advanceStroke(brushlessERPM / 60 / p.brushlessStrokeERevs * dt);
+  }
+
+  // the dart is pushed into the wheels half way through the stroke
+  void advanceStroke(double strokes)
+  {
+    double previous = n20Phase;
+    n20Phase += strokes;
+    if (previous < 0.5 && n20Phase >= 0.5)
+    {
+      fireDart();
+    }
+    if (n20Phase >= 1)
+    {
+      n20Phase -= 1;
+    }
+  }
+
+  plantParams_t p;
+  double omega = 0; // flywheel speed, rad/s
+  double duty = 0;
+  double batteryVoltage;
+  double solenoidOn_s = 0;
+  bool solenoidFed = false;
+  double n20Phase = 0; // 0 - 1 through the stroke, 0 is home, for the brushless pusher too
+  double n20Speed = 0; // strokes per second
+  double brushlessERPM = 0;
+  double lagDt = 0;
+  double escLag = 0;
+  double n20Drive = 0;
+  double n20Brake = 0;
+  double n20Coast = 0;
+  double brushlessSpinup = 0;
+};
+
+#endif // PLANT_H
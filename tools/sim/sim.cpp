@@ -0,0 +1,275 @@
+// Runs the firmware's Controller against the plant model in plant.h and sweeps controller
+// parameters, reporting time to ready, dart velocity consistency and achieved rate of fire.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -Isrc tools/sim/sim.cpp src/Control/*.cpp src/FireControl/scheduler.cpp -o sim
+//
+// Usage:
+//   sim [-n20 | -brushless] [-darts N] [-dt us] [-repull ms]
+//
+// Each sweep point fires a burst at several battery charge levels, releases and pulls the
+// trigger again repull ms after the burst ends (default 250), while the flywheels are spinning
+// down, and reports on that second burst. With -repull 0 the burst is fired from a standstill
+// instead and spindownSpeed, which can't matter then, is left out of the sweep. The plant is
+// stepped every dt (default 50us) while the pusher moves and every 250us while only the
+// flywheels do, the controller every targetLoopTime_us (1000us).
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "Control/controller.h"
+#include "plant.h"
+#include "../common/defaultParams.h"
+
+static const uint32_t tick_us = 1000;
+static const uint32_t timeout_us = 5000000;
+static const uint32_t idleDt_us = 250; // plant step while the pusher is at rest
+static const uint32_t pull_us = 50000; // burst mode finishes the burst after a short pull
+
+typedef struct {
+  double timeToReady_ms;  // trigger to wheels within 5% of the commanded speed, measured burst only
+  double firstDart_ms;    // trigger to first dart leaving
+  double meanVelocity_mps;
+  double velocitySpread;  // standard deviation over mean
+  double minVelocity_mps;
+  double dartsPerSecond;  // between first and last dart
+  uint32_t darts;
+  uint32_t offHome;       // pusher stops that missed the cycle switch, overrun or short
+} burstResult_t;
+
+enum simPusher_t {
+  SIM_SOLENOID,
+  SIM_N20,
+  SIM_BRUSHLESS,
+};
+
+static const char *const simPusherNames[] = {"solenoid", "N20", "brushless"};
+
+// the defaults have a fixed idle, so spindownSpeed alone sets the speed a re-pull starts from
+static controlParams_t baseParams(simPusher_t pusher)
+{
+  static const pusherType_t pusherTypes[] = {PUSHER_SOLENOID_OPENLOOP, PUSHER_MOTOR_CLOSEDLOOP, PUSHER_BRUSHLESS};
+  return defaultParams(pusherTypes[pusher]);
+}
+
+// with repull_us > 0 a first burst spins the wheels up and the second one is measured
+static burstResult_t runBurst(const controlParams_t &params, const plantParams_t &plantParams, simPusher_t pusher,
+                              uint32_t dt_us, uint32_t repull_us)
+{
+  Controller controller;
+  controller.configure(params);
+  Plant plant(plantParams);
+  plant.n20 = pusher == SIM_N20;
+  plant.brushless = pusher == SIM_BRUSHLESS;
+
+  controlInputs_t inputs = {};
+  inputs.armed = true;
+  controlOutputs_t outputs = {};
+  burstResult_t result = {-1, -1, 0, 0, 1e9, 0, 0, 0};
+  bool wasFiring = false;
+  double velocitySum = 0;
+  double velocitySquares = 0;
+  uint32_t firstDart_us = 0;
+  uint32_t lastDart_us = 0;
+  uint32_t pullAt_us = 0;
+  bool measuring = repull_us == 0;
+  uint32_t nextTick_us = 0;
+
+  uint32_t step_us = dt_us;
+  for (uint32_t now_us = 0; now_us < timeout_us; now_us += step_us)
+  {
+    if ((int32_t)(now_us - nextTick_us) >= 0)
+    {
+      inputs.time_us = now_us;
+      inputs.time_ms = now_us / 1000;
+      inputs.trigger = now_us >= pullAt_us && now_us - pullAt_us < pull_us;
+      inputs.cycle = plant.cycleSwitch();
+      inputs.battery_mv = plant.batteryAdc_mv();
+      inputs.pusherERPM = plant.pusherERPM();
+      controller.tick(inputs, outputs);
+      plant.throttle = outputs.throttle;
+      plant.pusher = outputs.pusher;
+      plant.pusherBrake = outputs.pusherBrake;
+      plant.pusherThrottle = outputs.pusherThrottle;
+      wasFiring = wasFiring || controller.firing();
+      nextTick_us = controller.wakeTime_us(now_us, now_us + tick_us);
+    }
+
+    // coarser steps while only the flywheels move, landing on the next tick
+    step_us = plant.pusherAtRest() ? idleDt_us : dt_us;
+    if (step_us < dt_us)
+    {
+      step_us = dt_us;
+    }
+    if (step_us > nextTick_us - now_us)
+    {
+      step_us = nextTick_us - now_us;
+    }
+    plant.step(step_us * 1e-6);
+
+    double commandedRPM = plantParams.motorKv_rpmPerVolt * plantParams.batteryOpenCircuit_v * outputs.throttle / 1999.0;
+    bool pulled = measuring && now_us >= pullAt_us;
+    if (pulled && result.timeToReady_ms < 0 && outputs.throttle > 0 && plant.wheelRPM() >= 0.95 * commandedRPM)
+    {
+      result.timeToReady_ms = (now_us - pullAt_us) / 1000.0;
+    }
+    if (plant.dartFired && !measuring)
+    {
+      result.darts++;
+    }
+    else if (plant.dartFired)
+    {
+      if (result.darts == 0)
+      {
+        firstDart_us = now_us;
+        result.firstDart_ms = (now_us - pullAt_us) / 1000.0;
+      }
+      lastDart_us = now_us;
+      result.darts++;
+      velocitySum += plant.dartVelocity_mps;
+      velocitySquares += plant.dartVelocity_mps * plant.dartVelocity_mps;
+      if (plant.dartVelocity_mps < result.minVelocity_mps)
+      {
+        result.minVelocity_mps = plant.dartVelocity_mps;
+      }
+    }
+    bool burstDone = result.darts >= params.fire.burstLength && !controller.firing() &&
+                     !controller.fireScheduler().pending() && now_us - pullAt_us >= pull_us;
+    if (burstDone && !measuring)
+    {
+      // spin up burst done, pull again while the wheels are spinning down
+      measuring = true;
+      pullAt_us = now_us + repull_us;
+      result.darts = 0;
+    }
+    else if (burstDone)
+    {
+      break;
+    }
+  }
+
+  // let the pusher come to rest and see where it stopped
+  if (pusher != SIM_SOLENOID && wasFiring)
+  {
+    for (uint32_t settle_us = 0; settle_us < 100000 && !plant.pusherAtRest(); settle_us += dt_us)
+    {
+      plant.step(dt_us * 1e-6);
+    }
+    result.offHome = plant.cycleSwitch() ? 0 : 1;
+  }
+
+  if (result.darts > 0)
+  {
+    result.meanVelocity_mps = velocitySum / result.darts;
+    double variance = velocitySquares / result.darts - result.meanVelocity_mps * result.meanVelocity_mps;
+    result.velocitySpread = variance > 0 ? sqrt(variance) / result.meanVelocity_mps : 0;
+  }
+  if (result.darts > 1)
+  {
+    result.dartsPerSecond = (result.darts - 1) / ((lastDart_us - firstDart_us) * 1e-6);
+  }
+  return result;
+}
+
+int main(int argc, char **argv)
+{
+  simPusher_t pusher = SIM_SOLENOID;
+  uint16_t darts = 5;
+  uint32_t dt_us = 50;
+  uint32_t repull_ms = 250;
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "-n20") == 0)
+    {
+      pusher = SIM_N20;
+    }
+    else if (strcmp(argv[i], "-brushless") == 0)
+    {
+      pusher = SIM_BRUSHLESS;
+    }
+    else if (strcmp(argv[i], "-darts") == 0 && i + 1 < argc)
+    {
+      darts = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-dt") == 0 && i + 1 < argc)
+    {
+      dt_us = atoi(argv[++i]);
+    }
+    else if (strcmp(argv[i], "-repull") == 0 && i + 1 < argc)
+    {
+      repull_ms = atoi(argv[++i]);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [-n20 | -brushless] [-darts N] [-dt us] [-repull ms]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (darts == 0 || dt_us == 0 || dt_us >= 1000)
+  {
+    fprintf(stderr, "darts must be at least 1 and dt between 1 and 999us\n");
+    return 2;
+  }
+
+  static const uint16_t firingDelays_ms[] = {50, 100, 150, 200, 250, 300};
+  static const uint16_t spindownSpeeds[] = {1, 5, 20};
+  size_t spindownCount = repull_ms > 0 ? sizeof(spindownSpeeds) / sizeof(spindownSpeeds[0]) : 1;
+  static const uint16_t ratesOfFire_dpm[] = {0, 600, 900, 1200};
+  static const double batteryLevels_v[] = {16.8, 15.2, 14.0}; // full, storage, nearly empty 4S
+
+  if (repull_ms > 0)
+  {
+    printf("%s pusher, %u dart bursts re-pulled %u ms into spindown, dt %u us\n", simPusherNames[pusher], darts,
+           repull_ms, dt_us);
+  }
+  else
+  {
+    printf("%s pusher, %u dart bursts from a standstill, dt %u us\n", simPusherNames[pusher], darts, dt_us);
+  }
+  printf("%8s %9s %8s | %8s %8s %8s %8s %8s %6s %7s\n", "delay_ms", "spindown", "rof_dpm", "ready_ms", "first_ms",
+         "vel_mps", "spread%", "min_mps", "dps", "offhome");
+
+  clock_t started = clock();
+  uint32_t bursts = 0;
+  for (uint16_t firingDelay_ms : firingDelays_ms)
+  {
+    for (size_t s = 0; s < spindownCount; s++)
+    {
+      uint16_t spindownSpeed = spindownSpeeds[s];
+      for (uint16_t rateOfFire_dpm : ratesOfFire_dpm)
+      {
+        controlParams_t params = baseParams(pusher);
+        params.firingDelay_ms = firingDelay_ms;
+        params.spindownSpeed = spindownSpeed;
+        params.fire.rateOfFire_dpm = rateOfFire_dpm;
+        params.fire.burstLength = darts;
+
+        burstResult_t total = {0, 0, 0, 0, 1e9, 0, 0, 0};
+        for (double battery_v : batteryLevels_v)
+        {
+          plantParams_t plantParams = defaultPlant;
+          plantParams.batteryOpenCircuit_v = battery_v;
+          burstResult_t result = runBurst(params, plantParams, pusher, dt_us, repull_ms * 1000);
+          total.timeToReady_ms += result.timeToReady_ms;
+          total.firstDart_ms += result.firstDart_ms;
+          total.meanVelocity_mps += result.meanVelocity_mps;
+          total.velocitySpread += result.velocitySpread;
+          total.dartsPerSecond += result.dartsPerSecond;
+          total.minVelocity_mps = fmin(total.minVelocity_mps, result.minVelocity_mps);
+          total.offHome += result.offHome;
+          bursts++;
+        }
+        double levels = sizeof(batteryLevels_v) / sizeof(batteryLevels_v[0]);
+        printf("%8u %9u %8u | %8.1f %8.1f %8.2f %8.2f %8.2f %6.1f %7u\n", firingDelay_ms, spindownSpeed, rateOfFire_dpm,
+               total.timeToReady_ms / levels, total.firstDart_ms / levels, total.meanVelocity_mps / levels,
+               100 * total.velocitySpread / levels, total.minVelocity_mps, total.dartsPerSecond / levels,
+               total.offHome);
+      }
+    }
+  }
+  double elapsed_s = (double)(clock() - started) / CLOCKS_PER_SEC;
+  printf("%u bursts in %.2f s, %.0f bursts per second\n", bursts, elapsed_s, elapsed_s > 0 ? bursts / elapsed_s : 0);
+  return 0;
+}
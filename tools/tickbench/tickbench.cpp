@@ -0,0 +1,116 @@
+// Times Controller::tick() for every pusher type and flywheel mode on the host, each variant
+// running the same scripted session of revs, trigger pulls and cycle switch changes.
+//
+// Build from the repository root:
+//   g++ -std=c++11 -O2 -Isrc tools/tickbench/tickbench.cpp src/Control/*.cpp src/FireControl/scheduler.cpp -o tickbench
+//
+// Usage:
+//   tickbench [ticks]
+//
+// Reports the mean over the best of several runs and the 99.9th percentile single tick, less the
+// cost of reading the clock. The very slowest tick on a desktop OS is a scheduler artifact.
+// Timing is from tools/common/benchTiming.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "Control/controller.h"
+#include "../common/benchTiming.h"
+#include "../common/defaultParams.h"
+
+static std::vector<controlInputs_t> script(uint32_t ticks)
+{
+  std::vector<controlInputs_t> inputs(ticks);
+  controlInputs_t in = {};
+  in.armed = true;
+  in.battery_mv = 1450;
+  uint32_t random = 2463534242u;
+  for (uint32_t i = 0; i < ticks; i++)
+  {
+    random ^= random << 13;
+    random ^= random >> 17;
+    random ^= random << 5;
+    in.time_us = i * 1000;
+    in.time_ms = i;
+    in.trigger = i % 700 < 120;               // a pull every 0.7s
+    in.rev = i % 5000 < 2500;                 // rev held half the time
+    in.cycle = (i + (random & 3)) % 60 < 10;  // pusher home every ~60ms, with some jitter
+    in.battery_mv = 1400 + (random >> 28);
+    in.pusherERPM = in.cycle ? 0 : 40000 + (random & 0xff) * 100; // a brushless pusher's telemetry while it runs
+    inputs[i] = in;
+  }
+  return inputs;
+}
+
+// the governor and a capped rate of fire, so their paths are timed too
+static controlParams_t variantParams(pusherType_t pusherType, bool closedLoopFlywheels)
+{
+  controlParams_t params = defaultParams(pusherType);
+  params.idleRPMMax = 20000;
+  params.closedLoopFlywheels = closedLoopFlywheels;
+  params.fire.mode = FIRE_AUTO;
+  params.fire.rateOfFire_dpm = 900;
+  return params;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t ticks = argc >= 2 ? atoi(argv[1]) : 200000;
+  if (ticks == 0)
+  {
+    fprintf(stderr, "usage: %s [ticks]\n", argv[0]);
+    return 2;
+  }
+  std::vector<controlInputs_t> inputs = script(ticks);
+
+  // taken off every single tick time
+  double clockOverhead_ns = benchClockOverhead_ns();
+
+  static const char *const pusherNames[] = {"none", "motor", "solenoid", "brushless"};
+  static const pusherType_t pusherTypes[] = {NO_PUSHER, PUSHER_MOTOR_CLOSEDLOOP, PUSHER_SOLENOID_OPENLOOP, PUSHER_BRUSHLESS};
+  printf("%-9s %-11s %10s %10s %8s\n", "pusher", "flywheels", "mean ns", "p99.9 ns", "shots");
+  std::vector<double> tickTimes_ns(ticks);
+  volatile uint32_t sink = 0; // keeps the outputs from being optimized out
+  for (pusherType_t pusherType : pusherTypes)
+  {
+    for (int closedLoop = 0; closedLoop < 2; closedLoop++)
+    {
+      uint32_t shots = 0;
+      double best_ns = benchBestOf([&]()
+                                   {
+        Controller controller;
+        controller.configure(variantParams(pusherType, closedLoop));
+        controlOutputs_t outputs = {};
+        double elapsed_ns = benchTime_ns([&]()
+                                         {
+          for (const controlInputs_t &in : inputs)
+          {
+            controller.tick(in, outputs);
+            sink = sink + outputs.throttle;
+          } });
+        shots = controller.fireScheduler().shotsFired();
+        return elapsed_ns / ticks; });
+
+      // again one tick at a time for the tail
+      double tail_ns = benchBestOf([&]()
+                                   {
+        Controller controller;
+        controller.configure(variantParams(pusherType, closedLoop));
+        controlOutputs_t outputs = {};
+        for (uint32_t i = 0; i < ticks; i++)
+        {
+          benchClock::time_point tickStart = benchClock::now();
+          controller.tick(inputs[i], outputs);
+          tickTimes_ns[i] = benchElapsed_ns(tickStart, benchClock::now()) - clockOverhead_ns;
+          sink = sink + outputs.throttle;
+        }
+        std::vector<double>::iterator tail = tickTimes_ns.begin() + (size_t)(ticks * 0.999);
+        std::nth_element(tickTimes_ns.begin(), tail, tickTimes_ns.end());
+        return *tail; });
+      printf("%-9s %-11s %10.1f %10.0f %8u\n", pusherNames[pusherType], closedLoop ? "closed loop" : "open loop", best_ns,
+             tail_ns, shots);
+    }
+  }
+  return 0;
+}